@@ -22,8 +22,15 @@
 #include "ac_in.h"
 
 #include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/bootloader/bootloader.h"
+#include "bricklib2/utility/pearson_hash.h"
+#include "bricklib2/utility/util_definitions.h"
 #include "configs/config_ac_in.h"
 #include "communication.h"
+#include "outage_log.h"
+#include "low_power.h"
+#include "timestamp.h"
+#include "scheduler.h"
 
 ACIn ac_in;
 ACInLED ac_in_led[2] = {
@@ -31,36 +38,593 @@ ACInLED ac_in_led[2] = {
     {AC_IN_LED_CH1_PIN}
 };
 
+#define ac_in_ch0_irq_handler IRQ_Hdlr_3
+#define ac_in_ch1_irq_handler IRQ_Hdlr_4
+
+// Current level of all channels from one load of the port input register (bit n = channel n)
+static inline uint8_t ac_in_get_input(void) {
+    return (AC_IN_INPUT_PORT->IN >> AC_IN_INPUT_SHIFT) & AC_IN_CHANNEL_MASK;
+}
+
+static inline bool ac_in_is_half_wave_late(const uint32_t gap, const uint32_t expected_gap) {
+    return (expected_gap != 0) && (gap > expected_gap + expected_gap/AC_IN_HALF_WAVE_TOLERANCE_DIV);
+}
+
+// Number of half-waves that are missing in a late gap, each one adds half a period
+static inline uint32_t ac_in_get_missed_half_waves(const uint8_t channel, const uint32_t gap, const uint32_t expected_gap) {
+    const uint32_t half_period = (ac_in.irq_rising_valid & (1 << channel)) && (ac_in.irq_period[channel] != 0) ? ac_in.irq_period[channel]/2 : expected_gap;
+    const uint32_t missed      = (gap - expected_gap + half_period/2)/half_period;
+
+    return missed == 0 ? 1 : missed;
+}
+
+// The edge interrupts only take timestamps, flag the edge, measure the period
+// between rising edges and the gaps between edges. Everything else is done in
+// ac_in_tick, so the timing of an edge does not depend on how long the main loop takes.
+// Has to be called with interrupts disabled if it is not called from the edge interrupt.
+static inline void ac_in_accept_edge(const uint8_t channel, const uint32_t time_us, const uint32_t time_ms, const uint8_t rising) {
+    const uint8_t mask = 1 << channel;
+
+    ac_in.irq_edge_time[channel] = time_ms;
+    ac_in.irq_edge |= mask;
+    ac_in.irq_edge_count[channel]++;
+    ac_in.irq_edge_total[channel]++;
+
+    if(!ac_in.irq_recorder_frozen) {
+        ac_in.irq_recorder[ac_in.irq_recorder_end] = (time_us & ~3) | (channel << 1) | rising;
+        ac_in.irq_recorder_end = (ac_in.irq_recorder_end + 1) & AC_IN_RECORDER_MASK;
+        if(ac_in.irq_recorder_count < AC_IN_RECORDER_SIZE) {
+            ac_in.irq_recorder_count++;
+        }
+    }
+
+    // The half-wave before this edge is compared to the half-wave one period earlier.
+    // Every missing half-wave in the gap is counted. If ac_in_tick already reported
+    // the edge as overdue, that half-wave is not counted again.
+    if(ac_in.irq_gap_valid & mask) {
+        const uint32_t gap = timestamp_diff_us(ac_in.irq_last_edge_us[channel], time_us);
+        const uint8_t direction = 1 << rising;
+        if(ac_in_is_half_wave_late(gap, ac_in.irq_gap[channel][rising])) {
+            uint32_t missed = ac_in_get_missed_half_waves(channel, gap, ac_in.irq_gap[channel][rising]);
+            if(ac_in.half_wave_overdue & mask) {
+                missed--;
+            }
+            ac_in.irq_half_wave_missed[channel] = MIN(ac_in.irq_half_wave_missed[channel] + missed, UINT8_MAX);
+
+            // Two late gaps in a row mean that the frequency changed
+            if(ac_in.irq_gap_late[channel] & direction) {
+                ac_in.irq_gap[channel][rising] = gap;
+            }
+            ac_in.irq_gap_late[channel] |= direction;
+        } else {
+            ac_in.irq_gap[channel][rising] = gap;
+            ac_in.irq_gap_late[channel]   &= ~direction;
+        }
+
+        // Only full periods, starting with a rising edge, are used for the duty cycle
+        if(ac_in.irq_rising_valid & mask) {
+            ac_in.irq_duty_cycle_sum[channel][rising] += gap;
+        }
+    }
+    ac_in.irq_last_edge_us[channel] = time_us;
+    ac_in.irq_gap_valid            |= mask;
+    ac_in.half_wave_overdue        &= ~mask;
+    if(rising) {
+        ac_in.irq_last_edge_rising |= mask;
+    } else {
+        ac_in.irq_last_edge_rising &= ~mask;
+    }
+
+    if(rising) {
+        if(ac_in.irq_rising_valid & mask) {
+            ac_in.irq_period[channel] = timestamp_diff_us(ac_in.irq_rising_time[channel], time_us);
+            ac_in.irq_period_done |= mask;
+
+            ac_in.irq_duty_cycle_count[channel]++;
+            if(ac_in.irq_duty_cycle_count[channel] >= ac_in.duty_cycle_average[channel]) {
+                ac_in.irq_duty_cycle_result[channel][0]    = ac_in.irq_duty_cycle_sum[channel][0];
+                ac_in.irq_duty_cycle_result[channel][1]    = ac_in.irq_duty_cycle_sum[channel][1];
+                ac_in.irq_duty_cycle_result_count[channel] = ac_in.irq_duty_cycle_count[channel];
+                ac_in.irq_duty_cycle_sum[channel][0]       = 0;
+                ac_in.irq_duty_cycle_sum[channel][1]       = 0;
+                ac_in.irq_duty_cycle_count[channel]        = 0;
+                ac_in.irq_duty_cycle_done |= mask;
+            }
+        }
+        ac_in.irq_rising_time[channel] = time_us;
+        ac_in.irq_rising_valid |= mask;
+    }
+}
+
+// With a minimum pulse width configured an edge is only accepted after the level
+// was stable for that long. If the next edge comes earlier, both edges were a glitch.
+// Pending edges that are not followed by another edge are accepted in ac_in_tick.
+static inline void ac_in_handle_edge(const uint8_t channel) {
+    const uint32_t time_us = timestamp_get_us();
+    const uint32_t time_ms = system_timer_get_ms();
+    const uint8_t mask     = 1 << channel;
+    const uint8_t rising   = (ac_in_get_input() & mask) ? 1 : 0;
+
+    if(ac_in.filter_pulse_width[channel] == 0) {
+        ac_in_accept_edge(channel, time_us, time_ms, rising);
+        return;
+    }
+
+    if(ac_in.irq_pending_edge & mask) {
+        ac_in.irq_pending_edge &= ~mask;
+        if(timestamp_diff_us(ac_in.irq_pending_time_us[channel], time_us) < ac_in.filter_pulse_width[channel]) {
+            return;
+        }
+
+        ac_in_accept_edge(channel, ac_in.irq_pending_time_us[channel], ac_in.irq_pending_time_ms[channel], ac_in.irq_pending_rising[channel]);
+    }
+
+    ac_in.irq_pending_time_us[channel] = time_us;
+    ac_in.irq_pending_time_ms[channel] = time_ms;
+    ac_in.irq_pending_rising[channel]  = rising;
+    ac_in.irq_pending_edge            |= mask;
+}
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) ac_in_ch0_irq_handler(void) {
+    ac_in_handle_edge(0);
+}
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) ac_in_ch1_irq_handler(void) {
+    ac_in_handle_edge(1);
+}
+
+uint32_t ac_in_get_frequency(const uint8_t channel) {
+    if(ac_in.period[channel] == 0) {
+        return 0;
+    }
+
+    // Frequency in mHz
+    return (1000000000 + ac_in.period[channel]/2) / ac_in.period[channel];
+}
+
+uint8_t ac_in_event_count(void) {
+    return (ac_in.event_end - ac_in.event_start) & AC_IN_EVENT_BUFFER_MASK;
+}
+
+static void ac_in_event_push(const uint32_t timestamp, const uint8_t changed) {
+    if(!ac_in.cb_event_stream_enabled) {
+        return;
+    }
+
+    // If the buffer is full we drop the oldest event, the host can see
+    // the gap through the sequence number and the overflow count
+    if(ac_in_event_count() == AC_IN_EVENT_BUFFER_MASK) {
+        ac_in.event_start = (ac_in.event_start + 1) & AC_IN_EVENT_BUFFER_MASK;
+        ac_in.event_sequence++;
+        ac_in.event_overflow_count++;
+    }
+
+    ac_in.event_buffer[ac_in.event_end].timestamp = timestamp;
+    ac_in.event_buffer[ac_in.event_end].changed   = changed;
+    ac_in.event_buffer[ac_in.event_end].value     = ac_in.value;
+    ac_in.event_end = (ac_in.event_end + 1) & AC_IN_EVENT_BUFFER_MASK;
+}
+
+// Adds the time since the last tick to the running outage or presence
+static void ac_in_update_durations(const uint32_t now) {
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        ACInStatistics *statistics = &ac_in.statistics[ch];
+        const uint32_t elapsed = now - statistics->last_update;
+
+        if(ac_in.statistics_present_active & (1 << ch)) {
+            statistics->present_total += elapsed;
+        } else if(ac_in.statistics_outage_active & (1 << ch)) {
+            statistics->outage_current += elapsed;
+        }
+        statistics->last_update = now;
+    }
+}
+
+static void ac_in_update_statistics(const uint8_t channel, const uint32_t timestamp) {
+    ACInStatistics *statistics = &ac_in.statistics[channel];
+    const uint8_t mask = 1 << channel;
+
+    if(ac_in.value & mask) {
+        // Time since the first edge that was already counted as outage. The edge
+        // can be newer than the last update, then nothing was counted yet.
+        const uint32_t since_edge = timestamp_is_before(statistics->last_update, timestamp) ? 0 : statistics->last_update - timestamp;
+
+        // The outage ends with the first edge. We only know the duration if we saw it start.
+        if(ac_in.statistics_outage_active & mask) {
+            static const uint32_t bounds[AC_IN_OUTAGE_HISTOGRAM_BUCKETS-1] = AC_IN_OUTAGE_HISTOGRAM_BOUNDS;
+            const uint64_t outage   = statistics->outage_current - MIN(since_edge, statistics->outage_current);
+            const uint32_t duration = MIN(outage, UINT32_MAX);
+
+            if((statistics->outage_count == 0) || (duration < statistics->outage_min)) {
+                statistics->outage_min = duration;
+            }
+            if(duration > statistics->outage_max) {
+                statistics->outage_max = duration;
+            }
+            statistics->outage_count++;
+            statistics->outage_total += outage;
+            statistics->outage_last   = duration;
+
+            uint8_t bucket = 0;
+            while((bucket < AC_IN_OUTAGE_HISTOGRAM_BUCKETS-1) && (duration >= bounds[bucket])) {
+                bucket++;
+            }
+            statistics->histogram[bucket]++;
+
+            outage_log_append(channel, statistics->outage_start, duration);
+        }
+
+        statistics->present_total       += since_edge;
+        statistics->outage_current       = 0;
+        ac_in.statistics_present_active |= mask;
+        ac_in.statistics_outage_active  &= ~mask;
+    } else {
+        // The outage started right after the last edge, not when the timeout ran out
+        const uint32_t last_edge  = ac_in.last_change[channel];
+        const uint32_t since_edge = timestamp_is_before(statistics->last_update, last_edge) ? 0 : statistics->last_update - last_edge;
+        if(ac_in.statistics_present_active & mask) {
+            statistics->present_total -= MIN(since_edge, statistics->present_total);
+        }
+
+        statistics->outage_start         = last_edge;
+        statistics->outage_current       = since_edge;
+        ac_in.statistics_outage_active  |= mask;
+        ac_in.statistics_present_active &= ~mask;
+    }
+}
+
+uint64_t ac_in_get_present_total(const uint8_t channel) {
+    // Includes the running presence up to the last tick
+    return ac_in.statistics[channel].present_total;
+}
+
+void ac_in_reset_statistics(const uint8_t channel) {
+    ACInStatistics *statistics = &ac_in.statistics[channel];
+    const uint32_t outage_start   = statistics->outage_start;
+    const uint64_t outage_current = statistics->outage_current;
+    const uint32_t last_update    = statistics->last_update;
+
+    memset(statistics, 0, sizeof(ACInStatistics));
+
+    // A running outage is still counted with its full duration
+    statistics->outage_start   = outage_start;
+    statistics->outage_current = outage_current;
+    statistics->last_update    = last_update;
+}
+
+// Freezes the recorder, it keeps the edges before the first trigger until it is armed again
+static void ac_in_recorder_trigger(const uint8_t cause, const uint8_t channel) {
+    if(ac_in.irq_recorder_frozen) {
+        return;
+    }
+
+    __disable_irq();
+    ac_in.irq_recorder_frozen = true;
+    ac_in.recorder_trigger_time = timestamp_get_us();
+    __enable_irq();
+
+    ac_in.recorder_trigger_cause   = cause;
+    ac_in.recorder_trigger_channel = channel;
+    ac_in.recorder_stream_offset   = 0;
+}
+
+void ac_in_recorder_arm(void) {
+    __disable_irq();
+    ac_in.irq_recorder_end    = 0;
+    ac_in.irq_recorder_count  = 0;
+    ac_in.irq_recorder_frozen = false;
+    __enable_irq();
+
+    ac_in.recorder_trigger_cause   = INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_NONE;
+    ac_in.recorder_trigger_channel = 0;
+    ac_in.recorder_trigger_time    = 0;
+    ac_in.recorder_stream_offset   = 0;
+}
+
+// Called for every change of ac_in.value, the new value is already set.
+// The statistics use the ms system timer, events use the us timestamp.
+static void ac_in_value_changed(const uint32_t timestamp, const uint32_t timestamp_us, const uint8_t changed) {
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        const uint8_t mask = 1 << ch;
+        if(changed & mask) {
+            ac_in_update_statistics(ch, timestamp);
+
+            if(ac_in.value & mask) {
+                if(ac_in.recorder_trigger_return & mask) {
+                    ac_in_recorder_trigger(INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_RETURN, ch);
+                }
+            } else if(ac_in.recorder_trigger_loss & mask) {
+                ac_in_recorder_trigger(INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_LOSS, ch);
+            }
+        }
+    }
+
+    ac_in_event_push(timestamp_us, changed);
+
+    if(ac_in.cb_coalesced_enabled) {
+        ac_in.cb_coalesced_changed  |= changed;
+        ac_in.cb_coalesced_timestamp = timestamp_us;
+    }
+
+    // Every transition is reported, a pulse between two sends is not collapsed.
+    // On overflow the count keeps its parity, so the last callback has the current value.
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        if(changed & ac_in.cb_value_immediate & (1 << ch)) {
+            if(ac_in.cb_value_immediate_count[ch] == UINT8_MAX) {
+                ac_in.cb_value_immediate_count[ch]--;
+            } else {
+                ac_in.cb_value_immediate_count[ch]++;
+            }
+        }
+    }
+    ac_in.cb_value_immediate_pending |= changed & ac_in.cb_value_immediate;
+}
+
+static void ac_in_missed_half_wave(const uint8_t channel, const uint8_t count) {
+    ac_in.missed_half_wave_count[channel] += count;
+    ac_in.cb_missed_half_wave_pending |= (1 << channel) & ac_in.cb_missed_half_wave_enabled;
+
+    if(ac_in.recorder_trigger_missed_half_wave & (1 << channel)) {
+        ac_in_recorder_trigger(INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_MISSED_HALF_WAVE, channel);
+    }
+}
+
+// Offset between the last rising edges of CH0 and CH1, relative to the period of CH0.
+// Called on every new period of CH1, so both rising edges belong to the same cycle.
+static void ac_in_update_phase(void) {
+    if(((ac_in.value & AC_IN_CHANNEL_MASK) != AC_IN_CHANNEL_MASK) || (ac_in.period[0] == 0)) {
+        ac_in.phase_valid = false;
+        return;
+    }
+
+    // CH0 can be ahead of or behind CH1, a negative offset is moved into the period
+    __disable_irq();
+    int32_t offset = (int32_t)(ac_in.irq_rising_time[1] - ac_in.irq_rising_time[0]);
+    __enable_irq();
+
+    offset %= (int32_t)ac_in.period[0];
+    if(offset < 0) {
+        offset += ac_in.period[0];
+    }
+
+    ac_in.phase       = (((uint32_t)offset)*3600) / ac_in.period[0];
+    ac_in.phase_valid = true;
+}
+
+// The opto only conducts while the line voltage is above its threshold, so the
+// on-time relative to the period goes down together with the amplitude.
+// The HCPL2731 output is open collector, the input is low while the opto conducts.
+static void ac_in_update_duty_cycle(const uint8_t channel) {
+    __disable_irq();
+    const uint32_t off   = ac_in.irq_duty_cycle_result[channel][0];
+    const uint32_t on    = ac_in.irq_duty_cycle_result[channel][1];
+    const uint8_t  count = ac_in.irq_duty_cycle_result_count[channel];
+    __enable_irq();
+
+    ac_in.on_time[channel]  = on/count;
+    ac_in.off_time[channel] = off/count;
+
+    const uint32_t period = ac_in.on_time[channel] + ac_in.off_time[channel];
+    if(period == 0) {
+        ac_in.duty_cycle[channel] = 0;
+    } else {
+        ac_in.duty_cycle[channel] = (ac_in.on_time[channel]*10000 + period/2)/period;
+    }
+}
+
+// Time in ms without an edge after which a channel is reported as "no AC voltage connected"
+static uint32_t ac_in_get_detection_timeout(const uint8_t channel) {
+    // The adaptive mode needs a measured period, until then the fixed timeout is used
+    if((ac_in.detection_mode[channel] == INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE) && (ac_in.period[channel] != 0)) {
+        // We expect an edge every half period. The next expected edge is allowed
+        // to be late by a half period, all edges after that are counted as missed.
+        const uint32_t half_period = ac_in.period[channel]/2;
+        return (half_period*(ac_in.detection_missed_edges[channel] + 1) + 999)/1000;
+    }
+
+    return ac_in.detection_timeout[channel];
+}
+
+// The time of the current main loop iteration (us or ms) is read before ac_in_tick
+// runs, so edges that were taken over from the interrupts can be newer than "now".
+// Those are never counted as elapsed.
+static inline bool ac_in_is_time_elapsed(const uint32_t now, const uint32_t start, const uint32_t time) {
+    return !timestamp_is_before(now, start) && ((now - start) >= time);
+}
+
+uint32_t ac_in_get_edge_count(const uint8_t channel, const bool reset) {
+    __disable_irq();
+    const uint32_t count = ac_in.irq_edge_total[channel];
+    if(reset) {
+        ac_in.irq_edge_total[channel] = 0;
+    }
+    __enable_irq();
+
+    return count;
+}
+
+// Without AC the opto output is static. The HCPL2731 output is open collector, so a
+// low input means the opto conducts all the time (DC or a rectified line without
+// ripple) and a high input means there is no voltage at all.
+static uint8_t ac_in_get_state(const uint8_t channel, const uint8_t input) {
+    const uint8_t mask = 1 << channel;
+    if(ac_in.value & mask) {
+        return INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_AC;
+    }
+
+    return (input & mask) ? INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_STEADY_LOW : INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_STEADY_HIGH;
+}
+
+bool ac_in_is_tick_pending(void) {
+    return (ac_in.irq_edge != 0) || (ac_in.irq_pending_edge != 0);
+}
+
 void ac_in_tick(void) {
-    // Handle AC input
-    bool new_value [2] = {
-        XMC_GPIO_GetInput(AC_IN_CH0_PIN),
-        XMC_GPIO_GetInput(AC_IN_CH1_PIN)
-    };
+    // One time read per main loop iteration, shared with all other tasks
+    const uint32_t now_ms = scheduler_get_ms();
+    const uint32_t now_us = scheduler_get_us();
+
+    ac_in_update_durations(now_ms);
+
+    // Take over all edges that were flagged by the interrupts since the last tick
+    __disable_irq();
+    if(ac_in.irq_pending_edge) {
+        for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+            if((ac_in.irq_pending_edge & (1 << ch)) && ac_in_is_time_elapsed(now_us, ac_in.irq_pending_time_us[ch], ac_in.filter_pulse_width[ch])) {
+                ac_in.irq_pending_edge &= ~(1 << ch);
+                ac_in_accept_edge(ch, ac_in.irq_pending_time_us[ch], ac_in.irq_pending_time_ms[ch], ac_in.irq_pending_rising[ch]);
+            }
+        }
+    }
+
+    uint8_t edge_count[AC_IN_CHANNEL_NUM];
+    uint8_t missed[AC_IN_CHANNEL_NUM];
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        edge_count[ch]                 = ac_in.irq_edge_count[ch];
+        missed[ch]                     = ac_in.irq_half_wave_missed[ch];
+        ac_in.irq_edge_count[ch]       = 0;
+        ac_in.irq_half_wave_missed[ch] = 0;
+    }
+
+    const uint8_t edge        = ac_in.irq_edge;
+    const uint8_t period_done = ac_in.irq_period_done;
+    const uint8_t duty_done   = ac_in.irq_duty_cycle_done;
+    ac_in.irq_edge            = 0;
+    ac_in.irq_period_done     = 0;
+    ac_in.irq_duty_cycle_done = 0;
+    __enable_irq();
 
+    const uint8_t input = ac_in_get_input();
+
+    // Handle AC input
+    uint8_t appeared = 0;
+    uint8_t lost     = 0;
     for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
-        if(new_value[ch] != ac_in.last_value[ch]) {
-            ac_in.last_value[ch]  = new_value[ch];
-            ac_in.last_change[ch] = system_timer_get_ms();
-            ac_in.value[ch]       = true;
+        const uint8_t mask = 1 << ch;
+
+        // An absent channel is only reported as present after the configured number
+        // of edges, each one within the detection timeout of the edge before.
+        // Edges that are too old are dropped in the first tick after the timeout,
+        // so last_change of an absent channel never gets old enough to wrap around.
+        if(!(ac_in.value & mask) && (ac_in.filter_edge_count[ch] != 0) &&
+           ac_in_is_time_elapsed(now_ms, ac_in.last_change[ch], ac_in_get_detection_timeout(ch))) {
+            ac_in.filter_edge_count[ch] = 0;
+        }
+
+        if(edge & mask) {
+            if(!(ac_in.value & mask)) {
+                ac_in.filter_edge_count[ch] = MIN(ac_in.filter_edge_count[ch] + edge_count[ch], 255);
+                if(ac_in.filter_edge_count[ch] >= ac_in.filter_min_edges[ch]) {
+                    appeared |= mask;
+                }
+            }
+
+            ac_in.last_change[ch] = ac_in.irq_edge_time[ch];
+        }
+
+        if(appeared & mask) {
+            ac_in.filter_edge_count[ch] = 0;
+            ac_in.value |= mask;
+            ac_in_value_changed(ac_in.last_change[ch], ac_in.irq_last_edge_us[ch], mask);
+        }
+
+        if(period_done & mask) {
+            // Smooth out the jitter of the opto threshold over the last few periods
+            const uint32_t period = ac_in.irq_period[ch];
+            if(ac_in.period[ch] == 0) {
+                ac_in.period[ch] = period;
+            } else {
+                ac_in.period[ch] = (ac_in.period[ch]*7 + period)/8;
+            }
+        }
+
+        if(duty_done & mask) {
+            ac_in_update_duty_cycle(ch);
+        }
+
+        if(missed[ch] != 0) {
+            ac_in_missed_half_wave(ch, missed[ch]);
+        }
+
+        if(!(ac_in.value & mask)) {
+            continue;
+        }
+
+        // If the next edge is already later than expected it is reported right away,
+        // without waiting for the edge or for the loss detection.
+        // An edge that waits for the glitch filter already ended the half-wave.
+        if(!(ac_in.half_wave_overdue & mask)) {
+            bool overdue = false;
+
+            __disable_irq();
+            const uint8_t next_rising = (ac_in.irq_last_edge_rising & mask) ? 0 : 1;
+            if((ac_in.irq_gap_valid & mask) && !(ac_in.irq_pending_edge & mask) &&
+               !timestamp_is_before(now_us, ac_in.irq_last_edge_us[ch]) &&
+               ac_in_is_half_wave_late(timestamp_diff_us(ac_in.irq_last_edge_us[ch], now_us), ac_in.irq_gap[ch][next_rising])) {
+                ac_in.half_wave_overdue |= mask;
+                overdue = true;
+            }
+            __enable_irq();
+
+            if(overdue) {
+                ac_in_missed_half_wave(ch, 1);
+            }
         }
 
         // At 50Hz we should see a change every 20ms
-        // Using 100ms without change as indicator for "no AC voltage connected"
-        if(system_timer_is_time_elapsed_ms(ac_in.last_change[ch], 100)) {
-            // re-set last change to 50ms in the past to make sure we never
-            // get a false positive because of the uint32 overflow
-            ac_in.last_change[ch] = system_timer_get_ms() - 150;
-            ac_in.value[ch]       = false;
+        // By default 100ms without change is used as indicator for "no AC voltage connected"
+        if(ac_in_is_time_elapsed(now_ms, ac_in.last_change[ch], ac_in_get_detection_timeout(ch))) {
+            lost |= mask;
+
+            // Next rising edge starts a new period measurement
+            ac_in.period[ch] = 0;
+            ac_in.duty_cycle[ch] = 0;
+            ac_in.on_time[ch]    = 0;
+            ac_in.off_time[ch]   = 0;
+        }
+    }
+
+    // New rising edge on CH1
+    if(period_done & (1 << 1)) {
+        ac_in_update_phase();
+    }
+
+    if(lost) {
+        ac_in.value &= ~lost;
+        ac_in.phase_valid = false;
+        ac_in_value_changed(now_ms, now_us, lost);
+
+        // Period, half-wave and duty cycle measurement start over with the next edge
+        __disable_irq();
+        ac_in.irq_rising_valid &= ~lost;
+        ac_in.irq_gap_valid    &= ~lost;
+        for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+            if(lost & (1 << ch)) {
+                ac_in.irq_gap[ch][0] = 0;
+                ac_in.irq_gap[ch][1] = 0;
+                ac_in.irq_gap_late[ch] = 0;
+                ac_in.irq_duty_cycle_sum[ch][0] = 0;
+                ac_in.irq_duty_cycle_sum[ch][1] = 0;
+                ac_in.irq_duty_cycle_count[ch]  = 0;
+            }
+        }
+        __enable_irq();
+    }
+
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        const uint8_t state = ac_in_get_state(ch, input);
+        if(state != ac_in.state[ch]) {
+            ac_in.state[ch]         = state;
+            ac_in.cb_state_pending |= (1 << ch) & ac_in.cb_state_enabled;
         }
     }
 
     // Handle LEDs
     for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
         if(ac_in.led_flicker_state[ch].config == INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_HEARTBEAT) {
-            led_flicker_tick(&ac_in.led_flicker_state[ch], system_timer_get_ms(), ac_in_led[ch].port, ac_in_led[ch].pin);
+            led_flicker_tick(&ac_in.led_flicker_state[ch], now_ms, ac_in_led[ch].port, ac_in_led[ch].pin);
         } else if(ac_in.led_flicker_state[ch].config == INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_CHANNEL_STATUS) {
-            if(ac_in.value[ch]) {
+            if(ac_in.value & (1 << ch)) {
                 XMC_GPIO_SetOutputLow(ac_in_led[ch].port, ac_in_led[ch].pin); // Channel LED on
             } else {
                 XMC_GPIO_SetOutputHigh(ac_in_led[ch].port, ac_in_led[ch].pin); // Channel LED off
@@ -69,6 +633,122 @@ void ac_in_tick(void) {
     }
 }
 
+static uint8_t ac_in_config_checksum(const uint32_t *page) {
+    const uint8_t *data = (const uint8_t*)&page[AC_IN_CONFIG_ALL_PERIOD_POS];
+    uint8_t checksum = 0;
+    for(uint16_t i = 0; i < (AC_IN_CONFIG_LENGTH - AC_IN_CONFIG_ALL_PERIOD_POS)*sizeof(uint32_t); i++) {
+        PEARSON(checksum, data[i]);
+    }
+
+    return checksum;
+}
+
+void ac_in_config_save(void) {
+    uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+    memset(page, 0, EEPROM_PAGE_SIZE);
+
+    page[AC_IN_CONFIG_MAGIC_POS]         = AC_IN_CONFIG_MAGIC;
+    page[AC_IN_CONFIG_VERSION_POS]       = AC_IN_CONFIG_VERSION;
+    page[AC_IN_CONFIG_ALL_PERIOD_POS]    = ac_in.cb_all_period;
+    page[AC_IN_CONFIG_FLAGS_POS]         = (ac_in.cb_all_has_to_change        << 0)  |
+                                           (ac_in.cb_event_stream_enabled     << 1)  |
+                                           (low_power.enabled                 << 2)  |
+                                           (ac_in.cb_coalesced_enabled        << 3)  |
+                                           (ac_in.cb_phase_has_to_change      << 4)  |
+                                           (ac_in.cb_value_immediate          << 8)  |
+                                           (ac_in.cb_state_enabled            << 16) |
+                                           (ac_in.cb_missed_half_wave_enabled << 24);
+    page[AC_IN_CONFIG_PHASE_PERIOD_POS]  = ac_in.cb_phase_period;
+    page[AC_IN_CONFIG_PHASE_MIN_MAX_POS] = (ac_in.cb_phase_min << 0) | (ac_in.cb_phase_max << 16);
+    page[AC_IN_CONFIG_PHASE_OPTION_POS]  = ac_in.cb_phase_option;
+
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        uint32_t *channel_page = &page[AC_IN_CONFIG_CHANNEL_POS + ch*AC_IN_CONFIG_CHANNEL_WORDS];
+        channel_page[0] = ac_in.cb_value_period[ch];
+        channel_page[1] = ac_in.cb_frequency_period[ch];
+        channel_page[2] = (ac_in.detection_timeout[ch]      << 0)  |
+                          (ac_in.detection_missed_edges[ch] << 16) |
+                          (ac_in.detection_mode[ch]         << 24);
+        channel_page[3] = (ac_in.led_flicker_state[ch].config    << 0)  |
+                          (ac_in.cb_value_has_to_change[ch]      << 8)  |
+                          (ac_in.cb_frequency_has_to_change[ch]  << 16) |
+                          (ac_in.cb_duty_cycle_has_to_change[ch] << 17) |
+                          (ac_in.cb_edge_count_has_to_change[ch] << 18) |
+                          (ac_in.cb_duty_cycle_option[ch]        << 24);
+        channel_page[4] = (ac_in.filter_pulse_width[ch] << 0)  |
+                          (ac_in.filter_min_edges[ch]   << 16) |
+                          (ac_in.duty_cycle_average[ch] << 24);
+        channel_page[5] = ac_in.cb_duty_cycle_period[ch];
+        channel_page[6] = (ac_in.cb_duty_cycle_min[ch] << 0) | (ac_in.cb_duty_cycle_max[ch] << 16);
+        channel_page[7] = ac_in.cb_edge_count_period[ch];
+    }
+
+    page[AC_IN_CONFIG_CHECKSUM_POS] = ac_in_config_checksum(page);
+
+    bootloader_write_eeprom_page(AC_IN_CONFIG_PAGE, page);
+}
+
+void ac_in_config_clear(void) {
+    uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+    memset(page, 0, EEPROM_PAGE_SIZE);
+
+    bootloader_write_eeprom_page(AC_IN_CONFIG_PAGE, page);
+}
+
+// Overwrites the defaults with the saved configuration, if there is a valid one
+static void ac_in_config_read(void) {
+    uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+    bootloader_read_eeprom_page(AC_IN_CONFIG_PAGE, page);
+
+    // Nothing was saved yet, the configuration was cleared, it was saved by a firmware
+    // with an incompatible layout or it is corrupted. In all cases we keep the defaults.
+    if((page[AC_IN_CONFIG_MAGIC_POS]    != AC_IN_CONFIG_MAGIC)   ||
+       (page[AC_IN_CONFIG_VERSION_POS]  != AC_IN_CONFIG_VERSION) ||
+       (page[AC_IN_CONFIG_CHECKSUM_POS] != ac_in_config_checksum(page))) {
+        return;
+    }
+
+    ac_in.cb_all_period               = page[AC_IN_CONFIG_ALL_PERIOD_POS];
+    ac_in.cb_all_has_to_change        = (page[AC_IN_CONFIG_FLAGS_POS] >> 0)  & 1;
+    ac_in.cb_event_stream_enabled     = (page[AC_IN_CONFIG_FLAGS_POS] >> 1)  & 1;
+    low_power.enabled                 = (page[AC_IN_CONFIG_FLAGS_POS] >> 2)  & 1;
+    ac_in.cb_coalesced_enabled        = (page[AC_IN_CONFIG_FLAGS_POS] >> 3)  & 1;
+    ac_in.cb_phase_has_to_change      = (page[AC_IN_CONFIG_FLAGS_POS] >> 4)  & 1;
+    ac_in.cb_value_immediate          = (page[AC_IN_CONFIG_FLAGS_POS] >> 8)  & AC_IN_CHANNEL_MASK;
+    ac_in.cb_state_enabled            = (page[AC_IN_CONFIG_FLAGS_POS] >> 16) & AC_IN_CHANNEL_MASK;
+    ac_in.cb_missed_half_wave_enabled = (page[AC_IN_CONFIG_FLAGS_POS] >> 24) & AC_IN_CHANNEL_MASK;
+    ac_in.cb_phase_period             = page[AC_IN_CONFIG_PHASE_PERIOD_POS];
+    ac_in.cb_phase_min                = (page[AC_IN_CONFIG_PHASE_MIN_MAX_POS] >> 0)  & 0xFFFF;
+    ac_in.cb_phase_max                = (page[AC_IN_CONFIG_PHASE_MIN_MAX_POS] >> 16) & 0xFFFF;
+    ac_in.cb_phase_option             = page[AC_IN_CONFIG_PHASE_OPTION_POS] & 0xFF;
+
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        const uint32_t *channel_page = &page[AC_IN_CONFIG_CHANNEL_POS + ch*AC_IN_CONFIG_CHANNEL_WORDS];
+        ac_in.cb_value_period[ch]             = channel_page[0];
+        ac_in.cb_frequency_period[ch]         = channel_page[1];
+        ac_in.detection_timeout[ch]           = (channel_page[2] >> 0)  & 0xFFFF;
+        ac_in.detection_missed_edges[ch]      = (channel_page[2] >> 16) & 0xFF;
+        ac_in.detection_mode[ch]              = (channel_page[2] >> 24) & 0xFF;
+        ac_in.led_flicker_state[ch].config    = (channel_page[3] >> 0)  & 0xFF;
+        ac_in.cb_value_has_to_change[ch]      = (channel_page[3] >> 8)  & 1;
+        ac_in.cb_frequency_has_to_change[ch]  = (channel_page[3] >> 16) & 1;
+        ac_in.cb_duty_cycle_has_to_change[ch] = (channel_page[3] >> 17) & 1;
+        ac_in.cb_edge_count_has_to_change[ch] = (channel_page[3] >> 18) & 1;
+        ac_in.cb_duty_cycle_option[ch]        = (channel_page[3] >> 24) & 0xFF;
+        ac_in.filter_pulse_width[ch]          = (channel_page[4] >> 0)  & 0xFFFF;
+        ac_in.filter_min_edges[ch]            = (channel_page[4] >> 16) & 0xFF;
+        ac_in.duty_cycle_average[ch]          = (channel_page[4] >> 24) & 0xFF;
+        ac_in.cb_duty_cycle_period[ch]        = channel_page[5];
+        ac_in.cb_duty_cycle_min[ch]           = (channel_page[6] >> 0)  & 0xFFFF;
+        ac_in.cb_duty_cycle_max[ch]           = (channel_page[6] >> 16) & 0xFFFF;
+        ac_in.cb_edge_count_period[ch]        = channel_page[7];
+
+        if(ac_in.led_flicker_state[ch].config == INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_ON) {
+            XMC_GPIO_SetOutputLow(ac_in_led[ch].port, ac_in_led[ch].pin);
+        }
+    }
+}
+
 void ac_in_init(void) {
     memset(&ac_in, 0, sizeof(ACIn));
 
@@ -79,6 +759,34 @@ void ac_in_init(void) {
     XMC_GPIO_Init(AC_IN_CH0_PIN, &channel_config);
     XMC_GPIO_Init(AC_IN_CH1_PIN, &channel_config);
 
+    // Event trigger logic: Trigger on both edges of the opto output
+    const XMC_ERU_ETL_CONFIG_t ch0_etl_config = {
+        .input_b                = AC_IN_CH0_ERU_INPUT,
+        .source                 = XMC_ERU_ETL_SOURCE_B,
+        .edge_detection         = XMC_ERU_ETL_EDGE_DETECTION_BOTH,
+        .status_flag_mode       = 0,
+        .enable_output_trigger  = 1,
+        .output_trigger_channel = AC_IN_CH0_ERU_OGU
+    };
+    XMC_ERU_ETL_Init(XMC_ERU0, AC_IN_CH0_ERU_ETL, &ch0_etl_config);
+
+    const XMC_ERU_ETL_CONFIG_t ch1_etl_config = {
+        .input_b                = AC_IN_CH1_ERU_INPUT,
+        .source                 = XMC_ERU_ETL_SOURCE_B,
+        .edge_detection         = XMC_ERU_ETL_EDGE_DETECTION_BOTH,
+        .status_flag_mode       = 0,
+        .enable_output_trigger  = 1,
+        .output_trigger_channel = AC_IN_CH1_ERU_OGU
+    };
+    XMC_ERU_ETL_Init(XMC_ERU0, AC_IN_CH1_ERU_ETL, &ch1_etl_config);
+
+    // Output gating unit: Generate a service request on every trigger
+    const XMC_ERU_OGU_CONFIG_t ogu_config = {
+        .service_request = XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER
+    };
+    XMC_ERU_OGU_Init(XMC_ERU0, AC_IN_CH0_ERU_OGU, &ogu_config);
+    XMC_ERU_OGU_Init(XMC_ERU0, AC_IN_CH1_ERU_OGU, &ogu_config);
+
     const XMC_GPIO_CONFIG_t channel_led_config = {
         .mode             = XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
         .output_level     = XMC_GPIO_OUTPUT_LEVEL_HIGH
@@ -87,17 +795,41 @@ void ac_in_init(void) {
     XMC_GPIO_Init(AC_IN_LED_CH1_PIN, &channel_led_config);
 
     // Initialize current value, last value and LED states
-    ac_in.value[0] = XMC_GPIO_GetInput(AC_IN_CH0_PIN);
-    ac_in.value[1] = XMC_GPIO_GetInput(AC_IN_CH1_PIN);
+    ac_in.value = ac_in_get_input();
 
-    ac_in.last_value[0] = ac_in.value[0];
-    ac_in.last_value[1] = ac_in.value[1];
+    ac_in.last_change[0] = system_timer_get_ms();
+    ac_in.last_change[1] = system_timer_get_ms();
 
-	ac_in.cb_value_last_value[0] = ac_in.value[0];
-	ac_in.cb_value_last_value[1] = ac_in.value[1];
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        ac_in.detection_mode[ch]         = INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_FIXED;
+        ac_in.detection_timeout[ch]      = 100;
+        ac_in.detection_missed_edges[ch] = 2;
+        ac_in.duty_cycle_average[ch]     = AC_IN_DUTY_CYCLE_AVERAGE_DEFAULT;
+        ac_in.filter_min_edges[ch]       = 1;
+        ac_in.cb_duty_cycle_option[ch]   = INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF;
+        ac_in.statistics[ch].last_update = ac_in.last_change[ch];
+    }
+    ac_in.statistics_present_active = ac_in.value;
 
-	ac_in.cb_all_last_value = ac_in.value[0] | (ac_in.value[1] << 1);
+    const uint8_t input = ac_in_get_input();
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        ac_in.state[ch] = ac_in_get_state(ch, input);
+    }
+
+	ac_in.cb_value_last_value           = ac_in.value;
+	ac_in.cb_value_immediate_last_value = ac_in.value;
+	ac_in.cb_all_last_value             = ac_in.value;
 
 	ac_in.led_flicker_state[0].config = INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_CHANNEL_STATUS;
 	ac_in.led_flicker_state[1].config = INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_CHANNEL_STATUS;
+
+	ac_in.cb_phase_option = INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF;
+
+    ac_in_config_read();
+
+    // Enable edge interrupts last, all state above has to be initialized first
+    NVIC_SetPriority(AC_IN_CH0_IRQ, AC_IN_CH0_IRQ_PRIORITY);
+    NVIC_SetPriority(AC_IN_CH1_IRQ, AC_IN_CH1_IRQ_PRIORITY);
+    NVIC_EnableIRQ(AC_IN_CH0_IRQ);
+    NVIC_EnableIRQ(AC_IN_CH1_IRQ);
 }
\ No newline at end of file
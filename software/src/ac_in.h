@@ -27,24 +27,206 @@
 #include "bricklib2/utility/led_flicker.h"
 
 #define AC_IN_CHANNEL_NUM 2
+#define AC_IN_CHANNEL_MASK ((1 << AC_IN_CHANNEL_NUM) - 1)
 
+// Configuration that is persisted in EEPROM page 1 with save_configuration.
+// Page 0 is used by the bootloader (UID), so we must not write it.
+#define AC_IN_CONFIG_PAGE              1
+#define AC_IN_CONFIG_MAGIC             0x41434346 // "ACCF"
+#define AC_IN_CONFIG_VERSION           3
+#define AC_IN_CONFIG_MAGIC_POS         0
+#define AC_IN_CONFIG_VERSION_POS       1
+#define AC_IN_CONFIG_CHECKSUM_POS      2
+#define AC_IN_CONFIG_ALL_PERIOD_POS    3
+#define AC_IN_CONFIG_FLAGS_POS         4
+#define AC_IN_CONFIG_PHASE_PERIOD_POS  5
+#define AC_IN_CONFIG_PHASE_MIN_MAX_POS 6
+#define AC_IN_CONFIG_PHASE_OPTION_POS  7
+#define AC_IN_CONFIG_CHANNEL_POS       8 // 8 words per channel
+#define AC_IN_CONFIG_CHANNEL_WORDS     8
+#define AC_IN_CONFIG_LENGTH            (AC_IN_CONFIG_CHANNEL_POS + AC_IN_CONFIG_CHANNEL_WORDS*AC_IN_CHANNEL_NUM)
+
+// An edge is late if its gap to the previous edge is more than 1/4 longer
+// than the gap before the previous edge of the same direction
+#define AC_IN_HALF_WAVE_TOLERANCE_DIV 4
+
+#define AC_IN_FILTER_PULSE_WIDTH_MAX 5000
+
+#define AC_IN_DUTY_CYCLE_AVERAGE_DEFAULT 10
+#define AC_IN_DUTY_CYCLE_AVERAGE_MAX     100
+
+// Upper bounds in ms of the outage histogram buckets, the last bucket has no upper bound
+#define AC_IN_OUTAGE_HISTOGRAM_BUCKETS 8
+#define AC_IN_OUTAGE_HISTOGRAM_BOUNDS {20, 100, 500, 1000, 5000, 30000, 300000}
+
+// The totals are 64 bit, they have to run for years. Single outages are capped at 2^32-1 ms.
+typedef struct {
+    uint32_t outage_count;
+    uint64_t outage_total; // all durations in ms
+    uint32_t outage_min;
+    uint32_t outage_max;
+    uint32_t outage_last;
+    uint64_t present_total;
+    uint32_t histogram[AC_IN_OUTAGE_HISTOGRAM_BUCKETS];
+
+    // The running outage or presence is accumulated in every tick,
+    // so no time difference gets old enough to wrap around
+    uint32_t outage_start; // uptime in ms, only used for the outage log
+    uint64_t outage_current;
+    uint32_t last_update;
+} ACInStatistics;
+
+#define AC_IN_EVENT_BUFFER_SIZE 32 // Has to be power of 2
+#define AC_IN_EVENT_BUFFER_MASK (AC_IN_EVENT_BUFFER_SIZE-1)
+
+typedef struct {
+    uint32_t timestamp; // in us
+    uint8_t changed;
+    uint8_t value;
+} ACInEvent;
+
+// Recorder entries are edge timestamps in us with the lowest two bits
+// replaced by the channel (bit 1) and the level after the edge (bit 0)
+#define AC_IN_RECORDER_SIZE 128 // Has to be power of 2
+#define AC_IN_RECORDER_MASK (AC_IN_RECORDER_SIZE-1)
+#define AC_IN_RECORDER_CHUNK_SIZE 15
+
+// All per-channel flags are bitmasks with bit n = channel n
 typedef struct {
-    bool last_value[AC_IN_CHANNEL_NUM];
+    // Written by the ERU edge interrupts, consumed by ac_in_tick
+    volatile uint8_t  irq_edge;
+    volatile uint8_t  irq_period_done;
+    volatile uint8_t  irq_rising_valid;
+    volatile uint32_t irq_edge_time[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_rising_time[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_period[AC_IN_CHANNEL_NUM];
+    volatile uint8_t  irq_edge_count[AC_IN_CHANNEL_NUM]; // Since the last tick
+    volatile uint32_t irq_edge_total[AC_IN_CHANNEL_NUM]; // Since start-up or reset
+
+    // Glitch filter: Edge that waits for the minimum pulse width to pass
+    volatile uint8_t  irq_pending_edge;
+    volatile uint8_t  irq_pending_rising[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_pending_time_us[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_pending_time_ms[AC_IN_CHANNEL_NUM];
+
+    // Pre-trigger recorder: Runs continuously until it is frozen by a trigger
+    volatile uint32_t irq_recorder[AC_IN_RECORDER_SIZE];
+    volatile uint8_t  irq_recorder_end;
+    volatile uint8_t  irq_recorder_count;
+    volatile bool     irq_recorder_frozen;
+
+    // Half-wave tracking: Gap in us before the last normal falling [0] and rising [1] edge.
+    // A late gap only replaces the reference gap if the gap before was late too.
+    volatile uint8_t  irq_gap_valid;
+    volatile uint8_t  half_wave_overdue; // Set by ac_in_tick, cleared by the next edge
+    volatile uint8_t  irq_last_edge_rising; // Direction of the last accepted edge
+    volatile uint8_t  irq_half_wave_missed[AC_IN_CHANNEL_NUM]; // Since the last tick
+    volatile uint8_t  irq_gap_late[AC_IN_CHANNEL_NUM]; // bit 0 = falling, bit 1 = rising
+    volatile uint32_t irq_last_edge_us[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_gap[AC_IN_CHANNEL_NUM][2];
+
+    // Duty cycle: Sum of the time in us before falling [0] (off) and rising [1] (on) edges,
+    // published after duty_cycle_average full periods
+    volatile uint8_t  irq_duty_cycle_done;
+    volatile uint8_t  irq_duty_cycle_count[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_duty_cycle_sum[AC_IN_CHANNEL_NUM][2];
+    volatile uint8_t  irq_duty_cycle_result_count[AC_IN_CHANNEL_NUM];
+    volatile uint32_t irq_duty_cycle_result[AC_IN_CHANNEL_NUM][2];
+
     uint32_t last_change[AC_IN_CHANNEL_NUM];
+    uint32_t period[AC_IN_CHANNEL_NUM]; // in us, 0 = no AC
+    uint32_t missed_half_wave_count[AC_IN_CHANNEL_NUM];
+
+    uint8_t  recorder_trigger_loss;
+    uint8_t  recorder_trigger_return;
+    uint8_t  recorder_trigger_missed_half_wave;
+    uint8_t  recorder_trigger_cause;
+    uint8_t  recorder_trigger_channel;
+    uint32_t recorder_trigger_time; // in us, same time base as the entries
+    uint16_t recorder_stream_offset;
+
+    ACInStatistics statistics[AC_IN_CHANNEL_NUM];
+    uint8_t statistics_outage_active;
+    uint8_t statistics_present_active;
+
+    uint16_t filter_pulse_width[AC_IN_CHANNEL_NUM]; // in us, 0 = off
+    uint8_t  filter_min_edges[AC_IN_CHANNEL_NUM];
+    uint8_t  filter_edge_count[AC_IN_CHANNEL_NUM];
 
-    bool value[AC_IN_CHANNEL_NUM];
+    uint8_t  duty_cycle_average[AC_IN_CHANNEL_NUM];
+    uint16_t duty_cycle[AC_IN_CHANNEL_NUM]; // in 1/100 %, 0 = no AC
+    uint32_t on_time[AC_IN_CHANNEL_NUM];    // in us
+    uint32_t off_time[AC_IN_CHANNEL_NUM];   // in us
+
+    // Phase of CH1 relative to CH0 in 1/10 degree
+    uint16_t phase;
+    bool     phase_valid;
+
+    uint8_t  detection_mode[AC_IN_CHANNEL_NUM];
+    uint16_t detection_timeout[AC_IN_CHANNEL_NUM];
+    uint8_t  detection_missed_edges[AC_IN_CHANNEL_NUM];
+
+    uint8_t value;
+    uint8_t state[AC_IN_CHANNEL_NUM];
 
     LEDFlickerState led_flicker_state[AC_IN_CHANNEL_NUM];
 
 	uint32_t cb_value_period[AC_IN_CHANNEL_NUM];
 	bool     cb_value_has_to_change[AC_IN_CHANNEL_NUM];
 	uint32_t cb_value_last_time[AC_IN_CHANNEL_NUM];
-	bool     cb_value_last_value[AC_IN_CHANNEL_NUM];
+	uint8_t  cb_value_last_value;
+	uint8_t  cb_value_immediate;
+	uint8_t  cb_value_immediate_pending;                  // Channels with unsent transitions
+	uint8_t  cb_value_immediate_count[AC_IN_CHANNEL_NUM]; // Number of unsent transitions
+	uint8_t  cb_value_immediate_last_value;               // Last value that was sent
+
+	bool     cb_coalesced_enabled;
+	uint8_t  cb_coalesced_changed;   // All changes since the last coalesced callback
+	uint32_t cb_coalesced_timestamp; // in us, time of the last change
 
 	uint32_t cb_all_period;
 	bool     cb_all_has_to_change;
 	uint32_t cb_all_last_time;
 	uint8_t  cb_all_last_value;
+
+	uint32_t cb_frequency_period[AC_IN_CHANNEL_NUM];
+	bool     cb_frequency_has_to_change[AC_IN_CHANNEL_NUM];
+	uint32_t cb_frequency_last_time[AC_IN_CHANNEL_NUM];
+	uint32_t cb_frequency_last_value[AC_IN_CHANNEL_NUM];
+
+	uint32_t cb_duty_cycle_period[AC_IN_CHANNEL_NUM];
+	bool     cb_duty_cycle_has_to_change[AC_IN_CHANNEL_NUM];
+	char     cb_duty_cycle_option[AC_IN_CHANNEL_NUM];
+	uint16_t cb_duty_cycle_min[AC_IN_CHANNEL_NUM];
+	uint16_t cb_duty_cycle_max[AC_IN_CHANNEL_NUM];
+	uint32_t cb_duty_cycle_last_time[AC_IN_CHANNEL_NUM];
+	uint16_t cb_duty_cycle_last_value[AC_IN_CHANNEL_NUM];
+
+	uint32_t cb_edge_count_period[AC_IN_CHANNEL_NUM];
+	bool     cb_edge_count_has_to_change[AC_IN_CHANNEL_NUM];
+	uint32_t cb_edge_count_last_time[AC_IN_CHANNEL_NUM];
+	uint32_t cb_edge_count_last_value[AC_IN_CHANNEL_NUM];
+
+	uint32_t cb_phase_period;
+	bool     cb_phase_has_to_change;
+	char     cb_phase_option;
+	uint16_t cb_phase_min;
+	uint16_t cb_phase_max;
+	uint32_t cb_phase_last_time;
+	uint16_t cb_phase_last_value;
+
+	uint8_t  cb_state_enabled;
+	uint8_t  cb_state_pending;
+
+	uint8_t  cb_missed_half_wave_enabled;
+	uint8_t  cb_missed_half_wave_pending;
+
+	bool      cb_event_stream_enabled;
+	ACInEvent event_buffer[AC_IN_EVENT_BUFFER_SIZE];
+	uint8_t   event_start;
+	uint8_t   event_end;
+	uint32_t  event_sequence; // Sequence number of the event at event_start
+	uint32_t  event_overflow_count;
 } ACIn;
 
 
@@ -56,6 +238,15 @@ typedef struct {
 extern ACIn ac_in;
 extern ACInLED ac_in_led[AC_IN_CHANNEL_NUM];
 
+uint32_t ac_in_get_frequency(const uint8_t channel);
+uint8_t ac_in_event_count(void);
+uint64_t ac_in_get_present_total(const uint8_t channel);
+void ac_in_reset_statistics(const uint8_t channel);
+void ac_in_recorder_arm(void);
+bool ac_in_is_tick_pending(void);
+uint32_t ac_in_get_edge_count(const uint8_t channel, const bool reset);
+void ac_in_config_save(void);
+void ac_in_config_clear(void);
 void ac_in_tick(void);
 void ac_in_init(void);
 
@@ -23,9 +23,36 @@
 
 #include "bricklib2/hal/system_timer/system_timer.h"
 #include "bricklib2/utility/communication_callback.h"
+#include "bricklib2/utility/util_definitions.h"
 #include "bricklib2/protocols/tfp/tfp.h"
 
 #include "ac_in.h"
+#include "waveform.h"
+#include "outage_log.h"
+#include "low_power.h"
+#include "timestamp.h"
+#include "time_sync.h"
+#include "loop_timing.h"
+
+// Threshold options as used by all Tinkerforge threshold callbacks
+static bool is_threshold_triggered(const char option, const uint32_t value, const uint32_t min, const uint32_t max) {
+	switch(option) {
+		case INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF:     return true;
+		case INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE: return (value < min) || (value > max);
+		case INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE:  return (value >= min) && (value <= max);
+		case INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER: return value < min;
+		case INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER: return value > min;
+		default: return false;
+	}
+}
+
+static bool is_threshold_option_valid(const char option) {
+	return (option == INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF)     ||
+	       (option == INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE) ||
+	       (option == INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE)  ||
+	       (option == INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER) ||
+	       (option == INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER);
+}
 
 BootloaderHandleMessageResponse handle_message(const void *message, void *response) {
 	switch(tfp_get_fid_from_message(message)) {
@@ -36,6 +63,61 @@ BootloaderHandleMessageResponse handle_message(const void *message, void *respon
 		case FID_GET_ALL_VALUE_CALLBACK_CONFIGURATION: return get_all_value_callback_configuration(message, response);
 		case FID_SET_CHANNEL_LED_CONFIG: return set_channel_led_config(message);
 		case FID_GET_CHANNEL_LED_CONFIG: return get_channel_led_config(message, response);
+		case FID_GET_FREQUENCY: return get_frequency(message, response);
+		case FID_GET_PERIOD: return get_period(message, response);
+		case FID_SET_FREQUENCY_CALLBACK_CONFIGURATION: return set_frequency_callback_configuration(message);
+		case FID_GET_FREQUENCY_CALLBACK_CONFIGURATION: return get_frequency_callback_configuration(message, response);
+		case FID_SET_DETECTION_CONFIGURATION: return set_detection_configuration(message);
+		case FID_GET_DETECTION_CONFIGURATION: return get_detection_configuration(message, response);
+		case FID_SET_EVENT_STREAM_CALLBACK_CONFIGURATION: return set_event_stream_callback_configuration(message);
+		case FID_GET_EVENT_STREAM_CALLBACK_CONFIGURATION: return get_event_stream_callback_configuration(message, response);
+		case FID_GET_MAIN_LOOP_TIMING: return get_main_loop_timing(message, response);
+		case FID_RESET_MAIN_LOOP_TIMING: return reset_main_loop_timing(message);
+		case FID_SET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION: return set_immediate_value_callback_configuration(message);
+		case FID_GET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION: return get_immediate_value_callback_configuration(message, response);
+		case FID_SAVE_CONFIGURATION: return save_configuration(message);
+		case FID_CLEAR_CONFIGURATION: return clear_configuration(message);
+		case FID_GET_MISSED_HALF_WAVE_COUNT: return get_missed_half_wave_count(message, response);
+		case FID_SET_MISSED_HALF_WAVE_CALLBACK_CONFIGURATION: return set_missed_half_wave_callback_configuration(message);
+		case FID_GET_MISSED_HALF_WAVE_CALLBACK_CONFIGURATION: return get_missed_half_wave_callback_configuration(message, response);
+		case FID_GET_PHASE: return get_phase(message, response);
+		case FID_SET_PHASE_CALLBACK_CONFIGURATION: return set_phase_callback_configuration(message);
+		case FID_GET_PHASE_CALLBACK_CONFIGURATION: return get_phase_callback_configuration(message, response);
+		case FID_GET_OUTAGE_STATISTICS: return get_outage_statistics(message, response);
+		case FID_GET_OUTAGE_HISTOGRAM: return get_outage_histogram(message, response);
+		case FID_RESET_OUTAGE_STATISTICS: return reset_outage_statistics(message);
+		case FID_GET_DUTY_CYCLE: return get_duty_cycle(message, response);
+		case FID_SET_DUTY_CYCLE_CONFIGURATION: return set_duty_cycle_configuration(message);
+		case FID_GET_DUTY_CYCLE_CONFIGURATION: return get_duty_cycle_configuration(message, response);
+		case FID_SET_DUTY_CYCLE_CALLBACK_CONFIGURATION: return set_duty_cycle_callback_configuration(message);
+		case FID_GET_DUTY_CYCLE_CALLBACK_CONFIGURATION: return get_duty_cycle_callback_configuration(message, response);
+		case FID_SET_FILTER_CONFIGURATION: return set_filter_configuration(message);
+		case FID_GET_FILTER_CONFIGURATION: return get_filter_configuration(message, response);
+		case FID_START_WAVEFORM_CAPTURE: return start_waveform_capture(message);
+		case FID_GET_WAVEFORM_CAPTURE_STATUS: return get_waveform_capture_status(message, response);
+		case FID_GET_WAVEFORM_LOW_LEVEL: return get_waveform_low_level(message, response);
+		case FID_SET_RECORDER_CONFIGURATION: return set_recorder_configuration(message);
+		case FID_GET_RECORDER_CONFIGURATION: return get_recorder_configuration(message, response);
+		case FID_ARM_RECORDER: return arm_recorder(message);
+		case FID_GET_RECORDER_STATUS: return get_recorder_status(message, response);
+		case FID_GET_RECORDER_LOW_LEVEL: return get_recorder_low_level(message, response);
+		case FID_GET_OUTAGE_LOG_LENGTH: return get_outage_log_length(message, response);
+		case FID_GET_OUTAGE_LOG_ENTRY: return get_outage_log_entry(message, response);
+		case FID_CLEAR_OUTAGE_LOG: return clear_outage_log(message);
+		case FID_SET_LOW_POWER_MODE: return set_low_power_mode(message);
+		case FID_GET_LOW_POWER_MODE: return get_low_power_mode(message, response);
+		case FID_GET_TIMESTAMP: return get_timestamp(message, response);
+		case FID_SET_COALESCED_VALUE_CALLBACK_CONFIGURATION: return set_coalesced_value_callback_configuration(message);
+		case FID_GET_COALESCED_VALUE_CALLBACK_CONFIGURATION: return get_coalesced_value_callback_configuration(message, response);
+		case FID_GET_EDGE_COUNT: return get_edge_count(message, response);
+		case FID_SET_EDGE_COUNT_CALLBACK_CONFIGURATION: return set_edge_count_callback_configuration(message);
+		case FID_GET_EDGE_COUNT_CALLBACK_CONFIGURATION: return get_edge_count_callback_configuration(message, response);
+		case FID_GET_CHANNEL_STATE: return get_channel_state(message, response);
+		case FID_SET_CHANNEL_STATE_CALLBACK_CONFIGURATION: return set_channel_state_callback_configuration(message);
+		case FID_GET_CHANNEL_STATE_CALLBACK_CONFIGURATION: return get_channel_state_callback_configuration(message, response);
+		case FID_SET_TIME_REFERENCE: return set_time_reference(message);
+		case FID_GET_TIME_SYNC_STATUS: return get_time_sync_status(message, response);
+		case FID_GET_SYNCED_TIMESTAMP: return get_synced_timestamp(message, response);
 		default: return HANDLE_MESSAGE_RESPONSE_NOT_SUPPORTED;
 	}
 }
@@ -43,7 +125,7 @@ BootloaderHandleMessageResponse handle_message(const void *message, void *respon
 
 BootloaderHandleMessageResponse get_value(const GetValue *data, GetValue_Response *response) {
 	response->header.length = sizeof(GetValue_Response);
-	response->value[0]      = ac_in.value[0] | (ac_in.value[1] << 1);
+	response->value[0]      = ac_in.value;
 
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
@@ -53,9 +135,11 @@ BootloaderHandleMessageResponse set_value_callback_configuration(const SetValueC
 		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}	
 
+	const uint8_t mask = 1 << data->channel;
+
 	ac_in.cb_value_period[data->channel]        = data->period;
 	ac_in.cb_value_has_to_change[data->channel] = data->value_has_to_change;
-	ac_in.cb_value_last_value[data->channel]    = ac_in.value[data->channel];
+	ac_in.cb_value_last_value                   = (ac_in.cb_value_last_value & ~mask) | (ac_in.value & mask);
 	ac_in.cb_value_last_time[data->channel]     = 0;
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
@@ -76,7 +160,7 @@ BootloaderHandleMessageResponse get_value_callback_configuration(const GetValueC
 BootloaderHandleMessageResponse set_all_value_callback_configuration(const SetAllValueCallbackConfiguration *data) {
 	ac_in.cb_all_period        = data->period;
 	ac_in.cb_all_has_to_change = data->value_has_to_change;
-	ac_in.cb_all_last_value    = ac_in.value[0] | (ac_in.value[1] << 1);
+	ac_in.cb_all_last_value    = ac_in.value;
 	ac_in.cb_all_last_time     = 0;
 
 	return HANDLE_MESSAGE_RESPONSE_EMPTY;
@@ -120,92 +204,1118 @@ BootloaderHandleMessageResponse get_channel_led_config(const GetChannelLEDConfig
 	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
 }
 
+BootloaderHandleMessageResponse get_frequency(const GetFrequency *data, GetFrequency_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
 
+	response->header.length = sizeof(GetFrequency_Response);
+	response->frequency     = ac_in_get_frequency(data->channel);
 
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
 
-bool handle_value_callback_channel(const uint8_t channel) {
-	static bool is_buffered[AC_IN_CHANNEL_NUM] = {false, false};
-	static Value_Callback cb[AC_IN_CHANNEL_NUM];
+BootloaderHandleMessageResponse get_period(const GetPeriod *data, GetPeriod_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
 
-	if(!is_buffered[channel]) {
-		if((ac_in.cb_value_period[channel] == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_value_last_time[channel], ac_in.cb_value_period[channel])) {
-			return false;
-		}
+	response->header.length = sizeof(GetPeriod_Response);
+	response->period        = ac_in.period[data->channel];
 
-		const bool changed = ac_in.cb_value_last_value[channel] != ac_in.value[channel];
-		if(ac_in.cb_value_has_to_change[channel] && !changed) {
-			return false;
-		}
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
 
-		tfp_make_default_header(&cb[channel].header, bootloader_get_uid(), sizeof(Value_Callback), FID_CALLBACK_VALUE);
-		cb[channel].channel = channel;
-		cb[channel].changed = changed;
-		cb[channel].value   = ac_in.value[channel];
+BootloaderHandleMessageResponse set_frequency_callback_configuration(const SetFrequencyCallbackConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
 
-		ac_in.cb_value_last_value[channel] = ac_in.value[channel];
-		ac_in.cb_value_last_time[channel]  = system_timer_get_ms();
+	ac_in.cb_frequency_period[data->channel]        = data->period;
+	ac_in.cb_frequency_has_to_change[data->channel] = data->value_has_to_change;
+	ac_in.cb_frequency_last_value[data->channel]    = ac_in_get_frequency(data->channel);
+	ac_in.cb_frequency_last_time[data->channel]     = 0;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_frequency_callback_configuration(const GetFrequencyCallbackConfiguration *data, GetFrequencyCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}
 
-	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
-		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb[channel], sizeof(Value_Callback));
-		is_buffered[channel] = false;
-		return true;
-	} else {
-		is_buffered[channel] = true;
+	response->header.length       = sizeof(GetFrequencyCallbackConfiguration_Response);
+	response->period              = ac_in.cb_frequency_period[data->channel];
+	response->value_has_to_change = ac_in.cb_frequency_has_to_change[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_detection_configuration(const SetDetectionConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}
 
-	return false;
+	if((data->mode > INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE) || (data->timeout == 0) || (data->missed_edges == 0)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in.detection_mode[data->channel]         = data->mode;
+	ac_in.detection_timeout[data->channel]      = data->timeout;
+	ac_in.detection_missed_edges[data->channel] = data->missed_edges;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
 
-bool handle_value_callback(void) {
-	static uint8_t channel = 0;
+BootloaderHandleMessageResponse get_detection_configuration(const GetDetectionConfiguration *data, GetDetectionConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
 
-	// Go through all channels round robin until one of the channels has something to send
-	for(uint8_t i = 0; i < AC_IN_CHANNEL_NUM; i++) {
-		bool ret = handle_value_callback_channel(channel);
-		channel = (channel+1) % AC_IN_CHANNEL_NUM;
-		if(ret) {
-			return true;
-		}
+	response->header.length = sizeof(GetDetectionConfiguration_Response);
+	response->mode          = ac_in.detection_mode[data->channel];
+	response->timeout       = ac_in.detection_timeout[data->channel];
+	response->missed_edges  = ac_in.detection_missed_edges[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_event_stream_callback_configuration(const SetEventStreamCallbackConfiguration *data) {
+	if(data->enabled && !ac_in.cb_event_stream_enabled) {
+		// Start with an empty history, sequence number and overflow count keep counting
+		ac_in.event_sequence += ac_in_event_count();
+		ac_in.event_start     = ac_in.event_end;
 	}
 
-	return false;
+	ac_in.cb_event_stream_enabled = data->enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
 }
 
-bool handle_all_value_callback(void) {
-	static bool is_buffered = false;
-	static AllValue_Callback cb;
-	if(!is_buffered) {
-		if((ac_in.cb_all_period == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_all_last_time, ac_in.cb_all_period)) {
-			return false;
-		}
+BootloaderHandleMessageResponse get_event_stream_callback_configuration(const GetEventStreamCallbackConfiguration *data, GetEventStreamCallbackConfiguration_Response *response) {
+	response->header.length = sizeof(GetEventStreamCallbackConfiguration_Response);
+	response->enabled       = ac_in.cb_event_stream_enabled;
 
-		const uint8_t value   = ac_in.value[0] | (ac_in.value[1] << 1);
-		const uint8_t changed = ac_in.cb_all_last_value ^ value;
-		if(ac_in.cb_all_has_to_change && (changed == 0)) {
-			return false;
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_main_loop_timing(const GetMainLoopTiming *data, GetMainLoopTiming_Response *response) {
+	response->header.length = sizeof(GetMainLoopTiming_Response);
+	response->loop_rate     = loop_timing.loop_rate;
+	for(uint8_t task = 0; task < LOOP_TIMING_TASK_NUM; task++) {
+		// Report 0 instead of UINT32_MAX if there was no measurement yet
+		response->min_cycles[task] = (loop_timing.min[task] == UINT32_MAX) ? 0 : loop_timing.min[task];
+		response->avg_cycles[task] = loop_timing.avg[task];
+		response->max_cycles[task] = loop_timing.max[task];
+	}
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse reset_main_loop_timing(const ResetMainLoopTiming *data) {
+	loop_timing_reset();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse set_immediate_value_callback_configuration(const SetImmediateValueCallbackConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t mask = 1 << data->channel;
+	if(data->enabled) {
+		if(!(ac_in.cb_value_immediate & mask)) {
+			ac_in.cb_value_immediate_last_value = (ac_in.cb_value_immediate_last_value & ~mask) | (ac_in.value & mask);
 		}
+		ac_in.cb_value_immediate |= mask;
+	} else {
+		ac_in.cb_value_immediate         &= ~mask;
+		ac_in.cb_value_immediate_pending &= ~mask;
+		ac_in.cb_value_immediate_count[data->channel] = 0;
+	}
 
-		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(AllValue_Callback), FID_CALLBACK_ALL_VALUE);
-		cb.changed[0] = changed;
-		cb.value[0]   = value;
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
 
-		ac_in.cb_all_last_value = value;
-		ac_in.cb_all_last_time  = system_timer_get_ms();
+BootloaderHandleMessageResponse get_immediate_value_callback_configuration(const GetImmediateValueCallbackConfiguration *data, GetImmediateValueCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
 	}
 
-	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
-		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(AllValue_Callback));
-		is_buffered = false;
-		return true;
+	response->header.length = sizeof(GetImmediateValueCallbackConfiguration_Response);
+	response->enabled       = (ac_in.cb_value_immediate & (1 << data->channel)) != 0;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data) {
+	ac_in_config_save();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse clear_configuration(const ClearConfiguration *data) {
+	ac_in_config_clear();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_missed_half_wave_count(const GetMissedHalfWaveCount *data, GetMissedHalfWaveCount_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetMissedHalfWaveCount_Response);
+	response->count         = ac_in.missed_half_wave_count[data->channel];
+
+	if(data->reset_counter) {
+		ac_in.missed_half_wave_count[data->channel] = 0;
+	}
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_missed_half_wave_callback_configuration(const SetMissedHalfWaveCallbackConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t mask = 1 << data->channel;
+	if(data->enabled) {
+		ac_in.cb_missed_half_wave_enabled |= mask;
 	} else {
-		is_buffered = true;
+		ac_in.cb_missed_half_wave_enabled &= ~mask;
+		ac_in.cb_missed_half_wave_pending &= ~mask;
 	}
 
-	return false;
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_missed_half_wave_callback_configuration(const GetMissedHalfWaveCallbackConfiguration *data, GetMissedHalfWaveCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetMissedHalfWaveCallbackConfiguration_Response);
+	response->enabled       = (ac_in.cb_missed_half_wave_enabled & (1 << data->channel)) != 0;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_phase(const GetPhase *data, GetPhase_Response *response) {
+	response->header.length = sizeof(GetPhase_Response);
+	response->phase         = ac_in.phase_valid ? ac_in.phase : 0;
+	response->valid         = ac_in.phase_valid;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_phase_callback_configuration(const SetPhaseCallbackConfiguration *data) {
+	if(!is_threshold_option_valid(data->option)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in.cb_phase_period        = data->period;
+	ac_in.cb_phase_has_to_change = data->value_has_to_change;
+	ac_in.cb_phase_option        = data->option;
+	ac_in.cb_phase_min           = data->min;
+	ac_in.cb_phase_max           = data->max;
+	ac_in.cb_phase_last_value    = ac_in.phase;
+	ac_in.cb_phase_last_time     = 0;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_phase_callback_configuration(const GetPhaseCallbackConfiguration *data, GetPhaseCallbackConfiguration_Response *response) {
+	response->header.length       = sizeof(GetPhaseCallbackConfiguration_Response);
+	response->period              = ac_in.cb_phase_period;
+	response->value_has_to_change = ac_in.cb_phase_has_to_change;
+	response->option              = ac_in.cb_phase_option;
+	response->min                 = ac_in.cb_phase_min;
+	response->max                 = ac_in.cb_phase_max;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_outage_statistics(const GetOutageStatistics *data, GetOutageStatistics_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const ACInStatistics *statistics = &ac_in.statistics[data->channel];
+
+	response->header.length = sizeof(GetOutageStatistics_Response);
+	response->outage_count  = statistics->outage_count;
+	response->outage_total  = statistics->outage_total;
+	response->outage_min    = statistics->outage_min;
+	response->outage_max    = statistics->outage_max;
+	response->outage_last   = statistics->outage_last;
+	response->present_total = ac_in_get_present_total(data->channel);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_outage_histogram(const GetOutageHistogram *data, GetOutageHistogram_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetOutageHistogram_Response);
+	memcpy(response->histogram, ac_in.statistics[data->channel].histogram, sizeof(response->histogram));
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse reset_outage_statistics(const ResetOutageStatistics *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in_reset_statistics(data->channel);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_duty_cycle(const GetDutyCycle *data, GetDutyCycle_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetDutyCycle_Response);
+	response->duty_cycle    = ac_in.duty_cycle[data->channel];
+	response->on_time       = ac_in.on_time[data->channel];
+	response->off_time      = ac_in.off_time[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_duty_cycle_configuration(const SetDutyCycleConfiguration *data) {
+	if((data->channel >= AC_IN_CHANNEL_NUM) || (data->average == 0) || (data->average > AC_IN_DUTY_CYCLE_AVERAGE_MAX)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in.duty_cycle_average[data->channel] = data->average;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_duty_cycle_configuration(const GetDutyCycleConfiguration *data, GetDutyCycleConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetDutyCycleConfiguration_Response);
+	response->average       = ac_in.duty_cycle_average[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_duty_cycle_callback_configuration(const SetDutyCycleCallbackConfiguration *data) {
+	if((data->channel >= AC_IN_CHANNEL_NUM) || !is_threshold_option_valid(data->option)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in.cb_duty_cycle_period[data->channel]        = data->period;
+	ac_in.cb_duty_cycle_has_to_change[data->channel] = data->value_has_to_change;
+	ac_in.cb_duty_cycle_option[data->channel]        = data->option;
+	ac_in.cb_duty_cycle_min[data->channel]           = data->min;
+	ac_in.cb_duty_cycle_max[data->channel]           = data->max;
+	ac_in.cb_duty_cycle_last_value[data->channel]    = ac_in.duty_cycle[data->channel];
+	ac_in.cb_duty_cycle_last_time[data->channel]     = 0;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_duty_cycle_callback_configuration(const GetDutyCycleCallbackConfiguration *data, GetDutyCycleCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length       = sizeof(GetDutyCycleCallbackConfiguration_Response);
+	response->period              = ac_in.cb_duty_cycle_period[data->channel];
+	response->value_has_to_change = ac_in.cb_duty_cycle_has_to_change[data->channel];
+	response->option              = ac_in.cb_duty_cycle_option[data->channel];
+	response->min                 = ac_in.cb_duty_cycle_min[data->channel];
+	response->max                 = ac_in.cb_duty_cycle_max[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_filter_configuration(const SetFilterConfiguration *data) {
+	if((data->channel >= AC_IN_CHANNEL_NUM) || (data->min_pulse_width > AC_IN_FILTER_PULSE_WIDTH_MAX) || (data->min_edges == 0)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	// A pending edge is accepted by the next ac_in_tick if the new pulse width already passed
+	ac_in.filter_pulse_width[data->channel] = data->min_pulse_width;
+	ac_in.filter_min_edges[data->channel]   = data->min_edges;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_filter_configuration(const GetFilterConfiguration *data, GetFilterConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length   = sizeof(GetFilterConfiguration_Response);
+	response->min_pulse_width = ac_in.filter_pulse_width[data->channel];
+	response->min_edges       = ac_in.filter_min_edges[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse start_waveform_capture(const StartWaveformCapture *data) {
+	if(data->sample_period < WAVEFORM_SAMPLE_PERIOD_MIN) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	waveform_start(data->sample_period);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_waveform_capture_status(const GetWaveformCaptureStatus *data, GetWaveformCaptureStatus_Response *response) {
+	response->header.length = sizeof(GetWaveformCaptureStatus_Response);
+	response->state         = waveform.state;
+	response->sample_period = waveform.sample_period;
+	response->sample_count  = waveform.sample_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_waveform_low_level(const GetWaveformLowLevel *data, GetWaveformLowLevel_Response *response) {
+	response->header.length = sizeof(GetWaveformLowLevel_Response);
+
+	// The waveform can only be read once the capture is done
+	if(waveform.state != INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_DONE) {
+		response->waveform_length       = 0;
+		response->waveform_chunk_offset = 0;
+		memset(response->waveform_chunk_data, 0, WAVEFORM_CHUNK_SIZE);
+
+		return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+	}
+
+	// Length and offset are in bits (one bool per channel per sample), a chunk always starts at a byte boundary
+	const uint16_t length = WAVEFORM_SAMPLE_NUM*AC_IN_CHANNEL_NUM;
+	if(waveform.stream_offset >= length) {
+		waveform.stream_offset = 0;
+	}
+
+	const uint16_t byte_offset = waveform.stream_offset/8;
+	const uint16_t bytes       = MIN(WAVEFORM_CHUNK_SIZE, WAVEFORM_BUFFER_SIZE - byte_offset);
+
+	response->waveform_length       = length;
+	response->waveform_chunk_offset = waveform.stream_offset;
+	memset(response->waveform_chunk_data, 0, WAVEFORM_CHUNK_SIZE);
+	memcpy(response->waveform_chunk_data, &waveform.buffer[byte_offset], bytes);
+
+	waveform.stream_offset += WAVEFORM_CHUNK_SIZE*8;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_recorder_configuration(const SetRecorderConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t mask = 1 << data->channel;
+	ac_in.recorder_trigger_loss             = (ac_in.recorder_trigger_loss             & ~mask) | (data->trigger_on_loss             ? mask : 0);
+	ac_in.recorder_trigger_return           = (ac_in.recorder_trigger_return           & ~mask) | (data->trigger_on_return           ? mask : 0);
+	ac_in.recorder_trigger_missed_half_wave = (ac_in.recorder_trigger_missed_half_wave & ~mask) | (data->trigger_on_missed_half_wave ? mask : 0);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_recorder_configuration(const GetRecorderConfiguration *data, GetRecorderConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t mask = 1 << data->channel;
+	response->header.length               = sizeof(GetRecorderConfiguration_Response);
+	response->trigger_on_loss             = (ac_in.recorder_trigger_loss             & mask) != 0;
+	response->trigger_on_return           = (ac_in.recorder_trigger_return           & mask) != 0;
+	response->trigger_on_missed_half_wave = (ac_in.recorder_trigger_missed_half_wave & mask) != 0;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse arm_recorder(const ArmRecorder *data) {
+	ac_in_recorder_arm();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_recorder_status(const GetRecorderStatus *data, GetRecorderStatus_Response *response) {
+	response->header.length   = sizeof(GetRecorderStatus_Response);
+	response->triggered       = ac_in.irq_recorder_frozen;
+	response->trigger_cause   = ac_in.recorder_trigger_cause;
+	response->trigger_channel = ac_in.recorder_trigger_channel;
+	response->trigger_time    = ac_in.recorder_trigger_time;
+	response->edge_count      = ac_in.irq_recorder_count;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_recorder_low_level(const GetRecorderLowLevel *data, GetRecorderLowLevel_Response *response) {
+	response->header.length = sizeof(GetRecorderLowLevel_Response);
+	memset(response->edges_chunk_data, 0, sizeof(response->edges_chunk_data));
+
+	// The edges can only be read while the recorder is frozen, oldest edge first
+	if(!ac_in.irq_recorder_frozen) {
+		response->edges_length       = 0;
+		response->edges_chunk_offset = 0;
+
+		return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+	}
+
+	const uint16_t length = ac_in.irq_recorder_count;
+	if(ac_in.recorder_stream_offset >= length) {
+		ac_in.recorder_stream_offset = 0;
+	}
+
+	const uint8_t start = (ac_in.irq_recorder_end - length) & AC_IN_RECORDER_MASK;
+	const uint16_t count = MIN(AC_IN_RECORDER_CHUNK_SIZE, length - ac_in.recorder_stream_offset);
+	for(uint16_t i = 0; i < count; i++) {
+		response->edges_chunk_data[i] = ac_in.irq_recorder[(start + ac_in.recorder_stream_offset + i) & AC_IN_RECORDER_MASK];
+	}
+
+	response->edges_length        = length;
+	response->edges_chunk_offset  = ac_in.recorder_stream_offset;
+	ac_in.recorder_stream_offset += AC_IN_RECORDER_CHUNK_SIZE;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_outage_log_length(const GetOutageLogLength *data, GetOutageLogLength_Response *response) {
+	response->header.length = sizeof(GetOutageLogLength_Response);
+	response->length        = outage_log_get_length();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_outage_log_entry(const GetOutageLogEntry *data, GetOutageLogEntry_Response *response) {
+	uint8_t channel;
+	uint32_t start;
+	uint32_t duration;
+	if(!outage_log_get_entry(data->index, &channel, &start, &duration)) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetOutageLogEntry_Response);
+	response->channel       = channel;
+	response->start         = start;
+	response->duration      = duration;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse clear_outage_log(const ClearOutageLog *data) {
+	outage_log_clear();
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse set_low_power_mode(const SetLowPowerMode *data) {
+	low_power.enabled = data->enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_low_power_mode(const GetLowPowerMode *data, GetLowPowerMode_Response *response) {
+	response->header.length = sizeof(GetLowPowerMode_Response);
+	response->enabled       = low_power.enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_timestamp(const GetTimestamp *data, GetTimestamp_Response *response) {
+	response->header.length = sizeof(GetTimestamp_Response);
+	response->timestamp     = timestamp_get_us();
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_coalesced_value_callback_configuration(const SetCoalescedValueCallbackConfiguration *data) {
+	if(data->enabled && !ac_in.cb_coalesced_enabled) {
+		ac_in.cb_coalesced_changed = 0;
+	} else if(!data->enabled && ac_in.cb_coalesced_enabled) {
+		// The changes while coalesced mode was enabled were already reported
+		ac_in.cb_value_last_value = ac_in.value;
+		ac_in.cb_all_last_value   = ac_in.value;
+	}
+
+	ac_in.cb_coalesced_enabled = data->enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_coalesced_value_callback_configuration(const GetCoalescedValueCallbackConfiguration *data, GetCoalescedValueCallbackConfiguration_Response *response) {
+	response->header.length = sizeof(GetCoalescedValueCallbackConfiguration_Response);
+	response->enabled       = ac_in.cb_coalesced_enabled;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_edge_count(const GetEdgeCount *data, GetEdgeCount_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetEdgeCount_Response);
+	response->count         = ac_in_get_edge_count(data->channel, data->reset_counter);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_edge_count_callback_configuration(const SetEdgeCountCallbackConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	ac_in.cb_edge_count_period[data->channel]        = data->period;
+	ac_in.cb_edge_count_has_to_change[data->channel] = data->value_has_to_change;
+	ac_in.cb_edge_count_last_value[data->channel]    = ac_in_get_edge_count(data->channel, false);
+	ac_in.cb_edge_count_last_time[data->channel]     = 0;
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_edge_count_callback_configuration(const GetEdgeCountCallbackConfiguration *data, GetEdgeCountCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length       = sizeof(GetEdgeCountCallbackConfiguration_Response);
+	response->period              = ac_in.cb_edge_count_period[data->channel];
+	response->value_has_to_change = ac_in.cb_edge_count_has_to_change[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse get_channel_state(const GetChannelState *data, GetChannelState_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetChannelState_Response);
+	response->state         = ac_in.state[data->channel];
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_channel_state_callback_configuration(const SetChannelStateCallbackConfiguration *data) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	const uint8_t mask = 1 << data->channel;
+	if(data->enabled) {
+		ac_in.cb_state_enabled |= mask;
+	} else {
+		ac_in.cb_state_enabled &= ~mask;
+		ac_in.cb_state_pending &= ~mask;
+	}
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_channel_state_callback_configuration(const GetChannelStateCallbackConfiguration *data, GetChannelStateCallbackConfiguration_Response *response) {
+	if(data->channel >= AC_IN_CHANNEL_NUM) {
+		return HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER;
+	}
+
+	response->header.length = sizeof(GetChannelStateCallbackConfiguration_Response);
+	response->enabled       = (ac_in.cb_state_enabled & (1 << data->channel)) != 0;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+BootloaderHandleMessageResponse set_time_reference(const SetTimeReference *data) {
+	time_sync_set_reference(data->host_time);
+
+	return HANDLE_MESSAGE_RESPONSE_EMPTY;
+}
+
+BootloaderHandleMessageResponse get_time_sync_status(const GetTimeSyncStatus *data, GetTimeSyncStatus_Response *response) {
+	response->header.length   = sizeof(GetTimeSyncStatus_Response);
+	response->synced          = time_sync.synced;
+	response->sync_count      = time_sync.sync_count;
+	response->reference_local = time_sync.reference.local;
+	response->reference_host  = time_sync.reference.host;
+	response->drift           = time_sync.drift;
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+// Converts a local us timestamp from the event stream, the coalesced value callback
+// or the recorder to host time. Hosts can also do this themselves with the time sync status.
+BootloaderHandleMessageResponse get_synced_timestamp(const GetSyncedTimestamp *data, GetSyncedTimestamp_Response *response) {
+	response->header.length    = sizeof(GetSyncedTimestamp_Response);
+	response->synced_timestamp = time_sync_get_synced(data->local_timestamp);
+
+	return HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE;
+}
+
+
+
+
+bool handle_value_callback_channel(const uint8_t channel) {
+	static bool is_buffered[AC_IN_CHANNEL_NUM] = {false, false};
+	static Value_Callback cb[AC_IN_CHANNEL_NUM];
+
+	if(!is_buffered[channel]) {
+		// The coalesced value callback replaces the value and all value callbacks
+		if(ac_in.cb_coalesced_enabled || (ac_in.cb_value_period[channel] == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_value_last_time[channel], ac_in.cb_value_period[channel])) {
+			return false;
+		}
+
+		const uint8_t mask    = 1 << channel;
+		const uint8_t changed = (ac_in.cb_value_last_value ^ ac_in.value) & mask;
+		if(ac_in.cb_value_has_to_change[channel] && !changed) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb[channel].header, bootloader_get_uid(), sizeof(Value_Callback), FID_CALLBACK_VALUE);
+		cb[channel].channel = channel;
+		cb[channel].changed = changed != 0;
+		cb[channel].value   = (ac_in.value & mask) != 0;
+
+		ac_in.cb_value_last_value ^= changed;
+		ac_in.cb_value_last_time[channel]  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb[channel], sizeof(Value_Callback));
+		is_buffered[channel] = false;
+		return true;
+	} else {
+		is_buffered[channel] = true;
+	}
+
+	return false;
+}
+
+bool handle_value_callback(void) {
+	static uint8_t channel = 0;
+
+	// Go through all channels round robin until one of the channels has something to send
+	for(uint8_t i = 0; i < AC_IN_CHANNEL_NUM; i++) {
+		bool ret = handle_value_callback_channel(channel);
+		channel = (channel+1) % AC_IN_CHANNEL_NUM;
+		if(ret) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool handle_all_value_callback(void) {
+	static bool is_buffered = false;
+	static AllValue_Callback cb;
+	if(!is_buffered) {
+		if(ac_in.cb_coalesced_enabled || (ac_in.cb_all_period == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_all_last_time, ac_in.cb_all_period)) {
+			return false;
+		}
+
+		const uint8_t value   = ac_in.value;
+		const uint8_t changed = ac_in.cb_all_last_value ^ value;
+		if(ac_in.cb_all_has_to_change && (changed == 0)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(AllValue_Callback), FID_CALLBACK_ALL_VALUE);
+		cb.changed[0] = changed;
+		cb.value[0]   = value;
+
+		ac_in.cb_all_last_value = value;
+		ac_in.cb_all_last_time  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(AllValue_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_frequency_callback_channel(const uint8_t channel) {
+	static bool is_buffered[AC_IN_CHANNEL_NUM] = {false, false};
+	static Frequency_Callback cb[AC_IN_CHANNEL_NUM];
+
+	if(!is_buffered[channel]) {
+		if((ac_in.cb_frequency_period[channel] == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_frequency_last_time[channel], ac_in.cb_frequency_period[channel])) {
+			return false;
+		}
+
+		const uint32_t frequency = ac_in_get_frequency(channel);
+		if(ac_in.cb_frequency_has_to_change[channel] && (ac_in.cb_frequency_last_value[channel] == frequency)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb[channel].header, bootloader_get_uid(), sizeof(Frequency_Callback), FID_CALLBACK_FREQUENCY);
+		cb[channel].channel   = channel;
+		cb[channel].frequency = frequency;
+		cb[channel].period    = ac_in.period[channel];
+
+		ac_in.cb_frequency_last_value[channel] = frequency;
+		ac_in.cb_frequency_last_time[channel]  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb[channel], sizeof(Frequency_Callback));
+		is_buffered[channel] = false;
+		return true;
+	} else {
+		is_buffered[channel] = true;
+	}
+
+	return false;
+}
+
+bool handle_frequency_callback(void) {
+	static uint8_t channel = 0;
+
+	// Go through all channels round robin until one of the channels has something to send
+	for(uint8_t i = 0; i < AC_IN_CHANNEL_NUM; i++) {
+		bool ret = handle_frequency_callback_channel(channel);
+		channel = (channel+1) % AC_IN_CHANNEL_NUM;
+		if(ret) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool handle_event_stream_callback(void) {
+	static bool is_buffered = false;
+	static EventStream_Callback cb;
+
+	if(!is_buffered) {
+		const uint8_t count = MIN(ac_in_event_count(), EVENT_STREAM_EVENTS_PER_CALLBACK);
+		if(!ac_in.cb_event_stream_enabled || (count == 0)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(EventStream_Callback), FID_CALLBACK_EVENT_STREAM);
+		cb.sequence       = ac_in.event_sequence;
+		cb.overflow_count = ac_in.event_overflow_count;
+		cb.event_count    = count;
+		for(uint8_t i = 0; i < EVENT_STREAM_EVENTS_PER_CALLBACK; i++) {
+			if(i < count) {
+				const ACInEvent *event = &ac_in.event_buffer[(ac_in.event_start + i) & AC_IN_EVENT_BUFFER_MASK];
+				cb.timestamp[i] = event->timestamp;
+				cb.changed[i]   = event->changed;
+				cb.value[i]     = event->value;
+			} else {
+				cb.timestamp[i] = 0;
+				cb.changed[i]   = 0;
+				cb.value[i]     = 0;
+			}
+		}
+
+		ac_in.event_start     = (ac_in.event_start + count) & AC_IN_EVENT_BUFFER_MASK;
+		ac_in.event_sequence += count;
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(EventStream_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_missed_half_wave_callback(void) {
+	static bool is_buffered = false;
+	static MissedHalfWave_Callback cb;
+
+	if(!is_buffered) {
+		if(ac_in.cb_missed_half_wave_pending == 0) {
+			return false;
+		}
+
+		uint8_t channel = 0;
+		while(!(ac_in.cb_missed_half_wave_pending & (1 << channel))) {
+			channel++;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(MissedHalfWave_Callback), FID_CALLBACK_MISSED_HALF_WAVE);
+		cb.channel = channel;
+		cb.count   = ac_in.missed_half_wave_count[channel];
+
+		ac_in.cb_missed_half_wave_pending &= ~(1 << channel);
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(MissedHalfWave_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_phase_callback(void) {
+	static bool is_buffered = false;
+	static Phase_Callback cb;
+
+	if(!is_buffered) {
+		if((ac_in.cb_phase_period == 0) || !ac_in.phase_valid || !system_timer_is_time_elapsed_ms(ac_in.cb_phase_last_time, ac_in.cb_phase_period)) {
+			return false;
+		}
+
+		if(ac_in.cb_phase_has_to_change && (ac_in.cb_phase_last_value == ac_in.phase)) {
+			return false;
+		}
+
+		if(!is_threshold_triggered(ac_in.cb_phase_option, ac_in.phase, ac_in.cb_phase_min, ac_in.cb_phase_max)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(Phase_Callback), FID_CALLBACK_PHASE);
+		cb.phase = ac_in.phase;
+
+		ac_in.cb_phase_last_value = ac_in.phase;
+		ac_in.cb_phase_last_time  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(Phase_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_duty_cycle_callback_channel(const uint8_t channel) {
+	static bool is_buffered[AC_IN_CHANNEL_NUM] = {false, false};
+	static DutyCycle_Callback cb[AC_IN_CHANNEL_NUM];
+
+	if(!is_buffered[channel]) {
+		if((ac_in.cb_duty_cycle_period[channel] == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_duty_cycle_last_time[channel], ac_in.cb_duty_cycle_period[channel])) {
+			return false;
+		}
+
+		const uint16_t duty_cycle = ac_in.duty_cycle[channel];
+		if(ac_in.cb_duty_cycle_has_to_change[channel] && (ac_in.cb_duty_cycle_last_value[channel] == duty_cycle)) {
+			return false;
+		}
+
+		if(!is_threshold_triggered(ac_in.cb_duty_cycle_option[channel], duty_cycle, ac_in.cb_duty_cycle_min[channel], ac_in.cb_duty_cycle_max[channel])) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb[channel].header, bootloader_get_uid(), sizeof(DutyCycle_Callback), FID_CALLBACK_DUTY_CYCLE);
+		cb[channel].channel    = channel;
+		cb[channel].duty_cycle = duty_cycle;
+		cb[channel].on_time    = ac_in.on_time[channel];
+		cb[channel].off_time   = ac_in.off_time[channel];
+
+		ac_in.cb_duty_cycle_last_value[channel] = duty_cycle;
+		ac_in.cb_duty_cycle_last_time[channel]  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb[channel], sizeof(DutyCycle_Callback));
+		is_buffered[channel] = false;
+		return true;
+	} else {
+		is_buffered[channel] = true;
+	}
+
+	return false;
+}
+
+bool handle_duty_cycle_callback(void) {
+	static uint8_t channel = 0;
+
+	// Go through all channels round robin until one of the channels has something to send
+	for(uint8_t i = 0; i < AC_IN_CHANNEL_NUM; i++) {
+		bool ret = handle_duty_cycle_callback_channel(channel);
+		channel = (channel+1) % AC_IN_CHANNEL_NUM;
+		if(ret) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// All value changes since the last callback in one message: changed channels,
+// current values of all channels and the us timestamp of the last change
+bool handle_coalesced_value_callback(void) {
+	static bool is_buffered = false;
+	static CoalescedValue_Callback cb;
+
+	if(!is_buffered) {
+		if(!ac_in.cb_coalesced_enabled || (ac_in.cb_coalesced_changed == 0)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(CoalescedValue_Callback), FID_CALLBACK_COALESCED_VALUE);
+		cb.changed   = ac_in.cb_coalesced_changed;
+		cb.value     = ac_in.value;
+		cb.timestamp = ac_in.cb_coalesced_timestamp;
+
+		ac_in.cb_coalesced_changed = 0;
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(CoalescedValue_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+bool handle_edge_count_callback_channel(const uint8_t channel) {
+	static bool is_buffered[AC_IN_CHANNEL_NUM] = {false, false};
+	static EdgeCount_Callback cb[AC_IN_CHANNEL_NUM];
+
+	if(!is_buffered[channel]) {
+		if((ac_in.cb_edge_count_period[channel] == 0) || !system_timer_is_time_elapsed_ms(ac_in.cb_edge_count_last_time[channel], ac_in.cb_edge_count_period[channel])) {
+			return false;
+		}
+
+		const uint32_t count = ac_in_get_edge_count(channel, false);
+		if(ac_in.cb_edge_count_has_to_change[channel] && (ac_in.cb_edge_count_last_value[channel] == count)) {
+			return false;
+		}
+
+		tfp_make_default_header(&cb[channel].header, bootloader_get_uid(), sizeof(EdgeCount_Callback), FID_CALLBACK_EDGE_COUNT);
+		cb[channel].channel = channel;
+		cb[channel].count   = count;
+
+		ac_in.cb_edge_count_last_value[channel] = count;
+		ac_in.cb_edge_count_last_time[channel]  = system_timer_get_ms();
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb[channel], sizeof(EdgeCount_Callback));
+		is_buffered[channel] = false;
+		return true;
+	} else {
+		is_buffered[channel] = true;
+	}
+
+	return false;
+}
+
+bool handle_edge_count_callback(void) {
+	static uint8_t channel = 0;
+
+	// Go through all channels round robin until one of the channels has something to send
+	for(uint8_t i = 0; i < AC_IN_CHANNEL_NUM; i++) {
+		bool ret = handle_edge_count_callback_channel(channel);
+		channel = (channel+1) % AC_IN_CHANNEL_NUM;
+		if(ret) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool handle_channel_state_callback(void) {
+	static bool is_buffered = false;
+	static ChannelState_Callback cb;
+
+	if(!is_buffered) {
+		if(ac_in.cb_state_pending == 0) {
+			return false;
+		}
+
+		uint8_t channel = 0;
+		while(!(ac_in.cb_state_pending & (1 << channel))) {
+			channel++;
+		}
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(ChannelState_Callback), FID_CALLBACK_CHANNEL_STATE);
+		cb.channel = channel;
+		cb.state   = ac_in.state[channel];
+
+		ac_in.cb_state_pending &= ~(1 << channel);
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(ChannelState_Callback));
+		is_buffered = false;
+		return true;
+	} else {
+		is_buffered = true;
+	}
+
+	return false;
+}
+
+// Value changes of channels with immediate value callback are sent with the next possible
+// SPITFP message, independent of the callback tick and the configured callback period
+// Sends one callback per transition. Each transition toggles the value, so the
+// value of the next unsent transition follows from the last value that was sent.
+static void handle_immediate_value_callback(void) {
+	static bool is_buffered = false;
+	static Value_Callback cb;
+	static uint8_t channel = 0;
+
+	if(!is_buffered) {
+		if(ac_in.cb_value_immediate_pending == 0) {
+			return;
+		}
+
+		// Go through all channels round robin, one channel can't hold back the other
+		while(!(ac_in.cb_value_immediate_pending & (1 << channel))) {
+			channel = (channel+1) % AC_IN_CHANNEL_NUM;
+		}
+
+		const uint8_t mask = 1 << channel;
+		ac_in.cb_value_immediate_last_value ^= mask;
+
+		tfp_make_default_header(&cb.header, bootloader_get_uid(), sizeof(Value_Callback), FID_CALLBACK_VALUE);
+		cb.channel = channel;
+		cb.changed = true;
+		cb.value   = (ac_in.cb_value_immediate_last_value & mask) != 0;
+
+		// The periodic value callback does not need to report this change again
+		ac_in.cb_value_last_value = (ac_in.cb_value_last_value & ~mask) | (ac_in.cb_value_immediate_last_value & mask);
+
+		ac_in.cb_value_immediate_count[channel]--;
+		if(ac_in.cb_value_immediate_count[channel] == 0) {
+			ac_in.cb_value_immediate_pending &= ~mask;
+		}
+		channel = (channel+1) % AC_IN_CHANNEL_NUM;
+	}
+
+	if(bootloader_spitfp_is_send_possible(&bootloader_status.st)) {
+		bootloader_spitfp_send_ack_and_message(&bootloader_status, (uint8_t*)&cb, sizeof(Value_Callback));
+		is_buffered = false;
+	} else {
+		is_buffered = true;
+	}
 }
 
 void communication_tick(void) {
+	handle_immediate_value_callback();
 	communication_callback_tick();
 }
 
@@ -43,6 +43,28 @@ void communication_init(void);
 #define INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_HEARTBEAT 2
 #define INDUSTRIAL_DUAL_AC_IN_CHANNEL_LED_CONFIG_SHOW_CHANNEL_STATUS 3
 
+#define INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_STEADY_LOW 0
+#define INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_STEADY_HIGH 1
+#define INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_AC 2
+
+#define INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_FIXED 0
+#define INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE 1
+
+#define INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF 'x'
+#define INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE 'o'
+#define INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE 'i'
+#define INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER '<'
+#define INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER '>'
+
+#define INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_IDLE 0
+#define INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_RUNNING 1
+#define INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_DONE 2
+
+#define INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_NONE 0
+#define INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_LOSS 1
+#define INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_RETURN 2
+#define INDUSTRIAL_DUAL_AC_IN_RECORDER_TRIGGER_MISSED_HALF_WAVE 3
+
 #define INDUSTRIAL_DUAL_AC_IN_BOOTLOADER_MODE_BOOTLOADER 0
 #define INDUSTRIAL_DUAL_AC_IN_BOOTLOADER_MODE_FIRMWARE 1
 #define INDUSTRIAL_DUAL_AC_IN_BOOTLOADER_MODE_BOOTLOADER_WAIT_FOR_REBOOT 2
@@ -69,9 +91,74 @@ void communication_init(void);
 #define FID_GET_ALL_VALUE_CALLBACK_CONFIGURATION 5
 #define FID_SET_CHANNEL_LED_CONFIG 6
 #define FID_GET_CHANNEL_LED_CONFIG 7
+#define FID_GET_FREQUENCY 10
+#define FID_GET_PERIOD 11
+#define FID_SET_FREQUENCY_CALLBACK_CONFIGURATION 12
+#define FID_GET_FREQUENCY_CALLBACK_CONFIGURATION 13
+#define FID_SET_DETECTION_CONFIGURATION 15
+#define FID_GET_DETECTION_CONFIGURATION 16
+#define FID_SET_EVENT_STREAM_CALLBACK_CONFIGURATION 17
+#define FID_GET_EVENT_STREAM_CALLBACK_CONFIGURATION 18
+#define FID_GET_MAIN_LOOP_TIMING 20
+#define FID_RESET_MAIN_LOOP_TIMING 21
+#define FID_SET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION 22
+#define FID_GET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION 23
+#define FID_SAVE_CONFIGURATION 24
+#define FID_CLEAR_CONFIGURATION 25
+#define FID_GET_MISSED_HALF_WAVE_COUNT 26
+#define FID_SET_MISSED_HALF_WAVE_CALLBACK_CONFIGURATION 27
+#define FID_GET_MISSED_HALF_WAVE_CALLBACK_CONFIGURATION 28
+#define FID_GET_PHASE 30
+#define FID_SET_PHASE_CALLBACK_CONFIGURATION 31
+#define FID_GET_PHASE_CALLBACK_CONFIGURATION 32
+#define FID_GET_OUTAGE_STATISTICS 34
+#define FID_GET_OUTAGE_HISTOGRAM 35
+#define FID_RESET_OUTAGE_STATISTICS 36
+#define FID_GET_DUTY_CYCLE 37
+#define FID_SET_DUTY_CYCLE_CONFIGURATION 38
+#define FID_GET_DUTY_CYCLE_CONFIGURATION 39
+#define FID_SET_DUTY_CYCLE_CALLBACK_CONFIGURATION 40
+#define FID_GET_DUTY_CYCLE_CALLBACK_CONFIGURATION 41
+#define FID_SET_FILTER_CONFIGURATION 43
+#define FID_GET_FILTER_CONFIGURATION 44
+#define FID_START_WAVEFORM_CAPTURE 45
+#define FID_GET_WAVEFORM_CAPTURE_STATUS 46
+#define FID_GET_WAVEFORM_LOW_LEVEL 47
+#define FID_SET_RECORDER_CONFIGURATION 48
+#define FID_GET_RECORDER_CONFIGURATION 49
+#define FID_ARM_RECORDER 50
+#define FID_GET_RECORDER_STATUS 51
+#define FID_GET_RECORDER_LOW_LEVEL 52
+#define FID_GET_OUTAGE_LOG_LENGTH 53
+#define FID_GET_OUTAGE_LOG_ENTRY 54
+#define FID_CLEAR_OUTAGE_LOG 55
+#define FID_SET_LOW_POWER_MODE 56
+#define FID_GET_LOW_POWER_MODE 57
+#define FID_GET_TIMESTAMP 58
+#define FID_SET_COALESCED_VALUE_CALLBACK_CONFIGURATION 59
+#define FID_GET_COALESCED_VALUE_CALLBACK_CONFIGURATION 60
+#define FID_GET_EDGE_COUNT 62
+#define FID_SET_EDGE_COUNT_CALLBACK_CONFIGURATION 63
+#define FID_GET_EDGE_COUNT_CALLBACK_CONFIGURATION 64
+#define FID_GET_CHANNEL_STATE 66
+#define FID_SET_CHANNEL_STATE_CALLBACK_CONFIGURATION 67
+#define FID_GET_CHANNEL_STATE_CALLBACK_CONFIGURATION 68
+#define FID_SET_TIME_REFERENCE 70
+#define FID_GET_TIME_SYNC_STATUS 71
+#define FID_GET_SYNCED_TIMESTAMP 72
 
 #define FID_CALLBACK_VALUE 8
 #define FID_CALLBACK_ALL_VALUE 9
+#define FID_CALLBACK_FREQUENCY 14
+#define FID_CALLBACK_EVENT_STREAM 19
+#define FID_CALLBACK_MISSED_HALF_WAVE 29
+#define FID_CALLBACK_PHASE 33
+#define FID_CALLBACK_DUTY_CYCLE 42
+#define FID_CALLBACK_COALESCED_VALUE 61
+#define FID_CALLBACK_EDGE_COUNT 65
+#define FID_CALLBACK_CHANNEL_STATE 69
+
+#define EVENT_STREAM_EVENTS_PER_CALLBACK 8
 
 typedef struct {
 	TFPMessageHeader header;
@@ -132,6 +219,497 @@ typedef struct {
 	uint8_t config;
 } __attribute__((__packed__)) GetChannelLEDConfig_Response;
 
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetFrequency;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t frequency;
+} __attribute__((__packed__)) GetFrequency_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetPeriod;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+} __attribute__((__packed__)) GetPeriod_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) SetFrequencyCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetFrequencyCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) GetFrequencyCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint8_t mode;
+	uint16_t timeout;
+	uint8_t missed_edges;
+} __attribute__((__packed__)) SetDetectionConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetDetectionConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t mode;
+	uint16_t timeout;
+	uint8_t missed_edges;
+} __attribute__((__packed__)) GetDetectionConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) SetEventStreamCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetEventStreamCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetEventStreamCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetMainLoopTiming;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t loop_rate;
+	uint32_t min_cycles[4];
+	uint32_t avg_cycles[4];
+	uint32_t max_cycles[4];
+} __attribute__((__packed__)) GetMainLoopTiming_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ResetMainLoopTiming;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool enabled;
+} __attribute__((__packed__)) SetImmediateValueCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetImmediateValueCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetImmediateValueCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) SaveConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ClearConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool reset_counter;
+} __attribute__((__packed__)) GetMissedHalfWaveCount;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t count;
+} __attribute__((__packed__)) GetMissedHalfWaveCount_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool enabled;
+} __attribute__((__packed__)) SetMissedHalfWaveCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetMissedHalfWaveCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetMissedHalfWaveCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetPhase;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t phase;
+	bool valid;
+} __attribute__((__packed__)) GetPhase_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	uint16_t min;
+	uint16_t max;
+} __attribute__((__packed__)) SetPhaseCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetPhaseCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	uint16_t min;
+	uint16_t max;
+} __attribute__((__packed__)) GetPhaseCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetOutageStatistics;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t outage_count;
+	uint64_t outage_total;
+	uint32_t outage_min;
+	uint32_t outage_max;
+	uint32_t outage_last;
+	uint64_t present_total;
+} __attribute__((__packed__)) GetOutageStatistics_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetOutageHistogram;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t histogram[8];
+} __attribute__((__packed__)) GetOutageHistogram_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) ResetOutageStatistics;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetDutyCycle;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t duty_cycle;
+	uint32_t on_time;
+	uint32_t off_time;
+} __attribute__((__packed__)) GetDutyCycle_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint8_t average;
+} __attribute__((__packed__)) SetDutyCycleConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetDutyCycleConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t average;
+} __attribute__((__packed__)) GetDutyCycleConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	uint16_t min;
+	uint16_t max;
+} __attribute__((__packed__)) SetDutyCycleCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetDutyCycleCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+	char option;
+	uint16_t min;
+	uint16_t max;
+} __attribute__((__packed__)) GetDutyCycleCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint16_t min_pulse_width;
+	uint8_t min_edges;
+} __attribute__((__packed__)) SetFilterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetFilterConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t min_pulse_width;
+	uint8_t min_edges;
+} __attribute__((__packed__)) GetFilterConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t sample_period;
+} __attribute__((__packed__)) StartWaveformCapture;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetWaveformCaptureStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t state;
+	uint16_t sample_period;
+	uint16_t sample_count;
+} __attribute__((__packed__)) GetWaveformCaptureStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetWaveformLowLevel;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t waveform_length;
+	uint16_t waveform_chunk_offset;
+	uint8_t waveform_chunk_data[60];
+} __attribute__((__packed__)) GetWaveformLowLevel_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool trigger_on_loss;
+	bool trigger_on_return;
+	bool trigger_on_missed_half_wave;
+} __attribute__((__packed__)) SetRecorderConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetRecorderConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool trigger_on_loss;
+	bool trigger_on_return;
+	bool trigger_on_missed_half_wave;
+} __attribute__((__packed__)) GetRecorderConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ArmRecorder;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetRecorderStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool triggered;
+	uint8_t trigger_cause;
+	uint8_t trigger_channel;
+	uint32_t trigger_time;
+	uint8_t edge_count;
+} __attribute__((__packed__)) GetRecorderStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetRecorderLowLevel;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t edges_length;
+	uint16_t edges_chunk_offset;
+	uint32_t edges_chunk_data[15];
+} __attribute__((__packed__)) GetRecorderLowLevel_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetOutageLogLength;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t length;
+} __attribute__((__packed__)) GetOutageLogLength_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t index;
+} __attribute__((__packed__)) GetOutageLogEntry;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t start;
+	uint32_t duration;
+} __attribute__((__packed__)) GetOutageLogEntry_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) ClearOutageLog;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) SetLowPowerMode;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetLowPowerMode;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetLowPowerMode_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetTimestamp;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t timestamp;
+} __attribute__((__packed__)) GetTimestamp_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) SetCoalescedValueCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetCoalescedValueCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetCoalescedValueCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool reset_counter;
+} __attribute__((__packed__)) GetEdgeCount;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t count;
+} __attribute__((__packed__)) GetEdgeCount_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) SetEdgeCountCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetEdgeCountCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t period;
+	bool value_has_to_change;
+} __attribute__((__packed__)) GetEdgeCountCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetChannelState;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t state;
+} __attribute__((__packed__)) GetChannelState_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	bool enabled;
+} __attribute__((__packed__)) SetChannelStateCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+} __attribute__((__packed__)) GetChannelStateCallbackConfiguration;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool enabled;
+} __attribute__((__packed__)) GetChannelStateCallbackConfiguration_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint64_t host_time;
+} __attribute__((__packed__)) SetTimeReference;
+
+typedef struct {
+	TFPMessageHeader header;
+} __attribute__((__packed__)) GetTimeSyncStatus;
+
+typedef struct {
+	TFPMessageHeader header;
+	bool synced;
+	uint32_t sync_count;
+	uint32_t reference_local;
+	uint64_t reference_host;
+	int32_t drift;
+} __attribute__((__packed__)) GetTimeSyncStatus_Response;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t local_timestamp;
+} __attribute__((__packed__)) GetSyncedTimestamp;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint64_t synced_timestamp;
+} __attribute__((__packed__)) GetSyncedTimestamp_Response;
+
 typedef struct {
 	TFPMessageHeader header;
 	uint8_t channel;
@@ -145,6 +723,61 @@ typedef struct {
 	uint8_t value[1];
 } __attribute__((__packed__)) AllValue_Callback;
 
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t frequency;
+	uint32_t period;
+} __attribute__((__packed__)) Frequency_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint32_t sequence;
+	uint32_t overflow_count;
+	uint8_t event_count;
+	uint32_t timestamp[EVENT_STREAM_EVENTS_PER_CALLBACK];
+	uint8_t changed[EVENT_STREAM_EVENTS_PER_CALLBACK];
+	uint8_t value[EVENT_STREAM_EVENTS_PER_CALLBACK];
+} __attribute__((__packed__)) EventStream_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t count;
+} __attribute__((__packed__)) MissedHalfWave_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint16_t phase;
+} __attribute__((__packed__)) Phase_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint16_t duty_cycle;
+	uint32_t on_time;
+	uint32_t off_time;
+} __attribute__((__packed__)) DutyCycle_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t changed;
+	uint8_t value;
+	uint32_t timestamp;
+} __attribute__((__packed__)) CoalescedValue_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint32_t count;
+} __attribute__((__packed__)) EdgeCount_Callback;
+
+typedef struct {
+	TFPMessageHeader header;
+	uint8_t channel;
+	uint8_t state;
+} __attribute__((__packed__)) ChannelState_Callback;
+
 
 // Function prototypes
 BootloaderHandleMessageResponse get_value(const GetValue *data, GetValue_Response *response);
@@ -154,16 +787,87 @@ BootloaderHandleMessageResponse set_all_value_callback_configuration(const SetAl
 BootloaderHandleMessageResponse get_all_value_callback_configuration(const GetAllValueCallbackConfiguration *data, GetAllValueCallbackConfiguration_Response *response);
 BootloaderHandleMessageResponse set_channel_led_config(const SetChannelLEDConfig *data);
 BootloaderHandleMessageResponse get_channel_led_config(const GetChannelLEDConfig *data, GetChannelLEDConfig_Response *response);
+BootloaderHandleMessageResponse get_frequency(const GetFrequency *data, GetFrequency_Response *response);
+BootloaderHandleMessageResponse get_period(const GetPeriod *data, GetPeriod_Response *response);
+BootloaderHandleMessageResponse set_frequency_callback_configuration(const SetFrequencyCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_frequency_callback_configuration(const GetFrequencyCallbackConfiguration *data, GetFrequencyCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse set_detection_configuration(const SetDetectionConfiguration *data);
+BootloaderHandleMessageResponse get_detection_configuration(const GetDetectionConfiguration *data, GetDetectionConfiguration_Response *response);
+BootloaderHandleMessageResponse set_event_stream_callback_configuration(const SetEventStreamCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_event_stream_callback_configuration(const GetEventStreamCallbackConfiguration *data, GetEventStreamCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_main_loop_timing(const GetMainLoopTiming *data, GetMainLoopTiming_Response *response);
+BootloaderHandleMessageResponse reset_main_loop_timing(const ResetMainLoopTiming *data);
+BootloaderHandleMessageResponse set_immediate_value_callback_configuration(const SetImmediateValueCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_immediate_value_callback_configuration(const GetImmediateValueCallbackConfiguration *data, GetImmediateValueCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse save_configuration(const SaveConfiguration *data);
+BootloaderHandleMessageResponse clear_configuration(const ClearConfiguration *data);
+BootloaderHandleMessageResponse get_missed_half_wave_count(const GetMissedHalfWaveCount *data, GetMissedHalfWaveCount_Response *response);
+BootloaderHandleMessageResponse set_missed_half_wave_callback_configuration(const SetMissedHalfWaveCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_missed_half_wave_callback_configuration(const GetMissedHalfWaveCallbackConfiguration *data, GetMissedHalfWaveCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_phase(const GetPhase *data, GetPhase_Response *response);
+BootloaderHandleMessageResponse set_phase_callback_configuration(const SetPhaseCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_phase_callback_configuration(const GetPhaseCallbackConfiguration *data, GetPhaseCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_outage_statistics(const GetOutageStatistics *data, GetOutageStatistics_Response *response);
+BootloaderHandleMessageResponse get_outage_histogram(const GetOutageHistogram *data, GetOutageHistogram_Response *response);
+BootloaderHandleMessageResponse reset_outage_statistics(const ResetOutageStatistics *data);
+BootloaderHandleMessageResponse get_duty_cycle(const GetDutyCycle *data, GetDutyCycle_Response *response);
+BootloaderHandleMessageResponse set_duty_cycle_configuration(const SetDutyCycleConfiguration *data);
+BootloaderHandleMessageResponse get_duty_cycle_configuration(const GetDutyCycleConfiguration *data, GetDutyCycleConfiguration_Response *response);
+BootloaderHandleMessageResponse set_duty_cycle_callback_configuration(const SetDutyCycleCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_duty_cycle_callback_configuration(const GetDutyCycleCallbackConfiguration *data, GetDutyCycleCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse set_filter_configuration(const SetFilterConfiguration *data);
+BootloaderHandleMessageResponse get_filter_configuration(const GetFilterConfiguration *data, GetFilterConfiguration_Response *response);
+BootloaderHandleMessageResponse start_waveform_capture(const StartWaveformCapture *data);
+BootloaderHandleMessageResponse get_waveform_capture_status(const GetWaveformCaptureStatus *data, GetWaveformCaptureStatus_Response *response);
+BootloaderHandleMessageResponse get_waveform_low_level(const GetWaveformLowLevel *data, GetWaveformLowLevel_Response *response);
+BootloaderHandleMessageResponse set_recorder_configuration(const SetRecorderConfiguration *data);
+BootloaderHandleMessageResponse get_recorder_configuration(const GetRecorderConfiguration *data, GetRecorderConfiguration_Response *response);
+BootloaderHandleMessageResponse arm_recorder(const ArmRecorder *data);
+BootloaderHandleMessageResponse get_recorder_status(const GetRecorderStatus *data, GetRecorderStatus_Response *response);
+BootloaderHandleMessageResponse get_recorder_low_level(const GetRecorderLowLevel *data, GetRecorderLowLevel_Response *response);
+BootloaderHandleMessageResponse get_outage_log_length(const GetOutageLogLength *data, GetOutageLogLength_Response *response);
+BootloaderHandleMessageResponse get_outage_log_entry(const GetOutageLogEntry *data, GetOutageLogEntry_Response *response);
+BootloaderHandleMessageResponse clear_outage_log(const ClearOutageLog *data);
+BootloaderHandleMessageResponse set_low_power_mode(const SetLowPowerMode *data);
+BootloaderHandleMessageResponse get_low_power_mode(const GetLowPowerMode *data, GetLowPowerMode_Response *response);
+BootloaderHandleMessageResponse get_timestamp(const GetTimestamp *data, GetTimestamp_Response *response);
+BootloaderHandleMessageResponse set_coalesced_value_callback_configuration(const SetCoalescedValueCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_coalesced_value_callback_configuration(const GetCoalescedValueCallbackConfiguration *data, GetCoalescedValueCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_edge_count(const GetEdgeCount *data, GetEdgeCount_Response *response);
+BootloaderHandleMessageResponse set_edge_count_callback_configuration(const SetEdgeCountCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_edge_count_callback_configuration(const GetEdgeCountCallbackConfiguration *data, GetEdgeCountCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse get_channel_state(const GetChannelState *data, GetChannelState_Response *response);
+BootloaderHandleMessageResponse set_channel_state_callback_configuration(const SetChannelStateCallbackConfiguration *data);
+BootloaderHandleMessageResponse get_channel_state_callback_configuration(const GetChannelStateCallbackConfiguration *data, GetChannelStateCallbackConfiguration_Response *response);
+BootloaderHandleMessageResponse set_time_reference(const SetTimeReference *data);
+BootloaderHandleMessageResponse get_time_sync_status(const GetTimeSyncStatus *data, GetTimeSyncStatus_Response *response);
+BootloaderHandleMessageResponse get_synced_timestamp(const GetSyncedTimestamp *data, GetSyncedTimestamp_Response *response);
 
 // Callbacks
 bool handle_value_callback(void);
 bool handle_all_value_callback(void);
+bool handle_frequency_callback(void);
+bool handle_event_stream_callback(void);
+bool handle_missed_half_wave_callback(void);
+bool handle_phase_callback(void);
+bool handle_duty_cycle_callback(void);
+bool handle_coalesced_value_callback(void);
+bool handle_edge_count_callback(void);
+bool handle_channel_state_callback(void);
 
 #define COMMUNICATION_CALLBACK_TICK_WAIT_MS 1
-#define COMMUNICATION_CALLBACK_HANDLER_NUM 2
+#define COMMUNICATION_CALLBACK_HANDLER_NUM 10
 #define COMMUNICATION_CALLBACK_LIST_INIT \
 	handle_value_callback, \
 	handle_all_value_callback, \
+	handle_frequency_callback, \
+	handle_event_stream_callback, \
+	handle_missed_half_wave_callback, \
+	handle_phase_callback, \
+	handle_duty_cycle_callback, \
+	handle_coalesced_value_callback, \
+	handle_edge_count_callback, \
+	handle_channel_state_callback, \
 
 
 #endif
@@ -23,10 +23,41 @@
 #define CONFIG_AC_IN_H
 
 #include "xmc_gpio.h"
+#include "xmc_eru.h"
+#include "xmc_ccu4.h"
 
 #define AC_IN_CH0_PIN P0_7
 #define AC_IN_CH1_PIN P0_8
 #define AC_IN_LED_CH0_PIN P0_12
 #define AC_IN_LED_CH1_PIN P0_9
 
+// The channel inputs are adjacent pins, so all of them can be read with one
+// load of the port input register (P0.7 = bit 0 = CH0, P0.8 = bit 1 = CH1)
+#define AC_IN_INPUT_PORT  PORT0
+#define AC_IN_INPUT_SHIFT 7
+
+// Both edges of the opto outputs are captured through ERU0 (P0.7 = ERU0.2B1, P0.8 = ERU0.3B1).
+// Each event trigger logic is routed to its own output gating unit and service request line.
+#define AC_IN_CH0_ERU_ETL          2
+#define AC_IN_CH0_ERU_INPUT        XMC_ERU_ETL_INPUT_B1
+#define AC_IN_CH0_ERU_OGU          0
+#define AC_IN_CH0_IRQ              3 // ERU0.SR0
+#define AC_IN_CH0_IRQ_PRIORITY     0
+
+#define AC_IN_CH1_ERU_ETL          3
+#define AC_IN_CH1_ERU_INPUT        XMC_ERU_ETL_INPUT_B1
+#define AC_IN_CH1_ERU_OGU          1
+#define AC_IN_CH1_IRQ              4 // ERU0.SR1
+#define AC_IN_CH1_IRQ_PRIORITY     0
+
+// CCU40 slice 2 generates the sample rate of the waveform capture. Its period match
+// interrupt has a lower priority than the edge interrupts, so edge timestamps stay exact.
+// Slices 0 and 1 of CCU40 are used for the timestamp (see config_timestamp.h).
+#define WAVEFORM_TIMER_CCU4        CCU40
+#define WAVEFORM_TIMER_SLICE       CCU40_CC42
+#define WAVEFORM_TIMER_SLICE_NUM   2
+#define WAVEFORM_TIMER_PRESCALER   XMC_CCU4_SLICE_PRESCALER_64 // 1 MHz
+#define WAVEFORM_IRQ               23 // CCU40.SR2
+#define WAVEFORM_IRQ_PRIORITY      1
+
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * config.h: Microsecond timestamp configurations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef CONFIG_TIMESTAMP_H
+#define CONFIG_TIMESTAMP_H
+
+#include "xmc_ccu4.h"
+
+// CCU40 slice 0 (low) and slice 1 (high) are concatenated to a free running 32 bit
+// microsecond timer. Slices 2 and 3 of CCU40 can be used by other modules.
+#define TIMESTAMP_CCU4             CCU40
+#define TIMESTAMP_SLICE_LOW        CCU40_CC40
+#define TIMESTAMP_SLICE_LOW_NUM    0
+#define TIMESTAMP_SLICE_HIGH       CCU40_CC41
+#define TIMESTAMP_SLICE_HIGH_NUM   1
+#define TIMESTAMP_PRESCALER        XMC_CCU4_SLICE_PRESCALER_64 // 64 MHz PCLK / 64 = 1 MHz
+
+#endif
@@ -0,0 +1,89 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * loop_timing.c: Execution time measurement of the main loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "loop_timing.h"
+
+#include <string.h>
+
+#include "configs/config.h"
+#include "bricklib2/hal/system_timer/system_timer.h"
+
+LoopTiming loop_timing;
+
+// CPU cycles since start-up (modulo 2^32), calculated from the ms counter
+// and the current value of the SysTick down-counter
+static uint32_t loop_timing_get_cycles(void) {
+    uint32_t ms  = system_timer_get_ms();
+    uint32_t val = SysTick->VAL;
+
+    // If the SysTick wrapped in between we re-read the counter value
+    const uint32_t ms_check = system_timer_get_ms();
+    if(ms != ms_check) {
+        ms  = ms_check;
+        val = SysTick->VAL;
+    }
+
+    return ms*(SysTick->LOAD + 1) + (SysTick->LOAD - val);
+}
+
+void loop_timing_start(void) {
+    loop_timing.loop_count++;
+    if(system_timer_is_time_elapsed_ms(loop_timing.loop_rate_time, 1000)) {
+        loop_timing.loop_rate      = loop_timing.loop_count;
+        loop_timing.loop_count     = 0;
+        loop_timing.loop_rate_time = system_timer_get_ms();
+    }
+
+    loop_timing.last_cycles = loop_timing_get_cycles();
+}
+
+void loop_timing_measure(const uint8_t task) {
+    const uint32_t cycles   = loop_timing_get_cycles();
+    const uint32_t duration = cycles - loop_timing.last_cycles;
+    loop_timing.last_cycles = cycles;
+
+    if(duration < loop_timing.min[task]) {
+        loop_timing.min[task] = duration;
+    }
+    if(duration > loop_timing.max[task]) {
+        loop_timing.max[task] = duration;
+    }
+
+    // Exponential moving average with a weight of 1/16 for the new value
+    if(loop_timing.avg[task] == 0) {
+        loop_timing.avg[task] = duration;
+    } else if(duration > loop_timing.avg[task]) {
+        loop_timing.avg[task] += (duration - loop_timing.avg[task])/16;
+    } else {
+        loop_timing.avg[task] -= (loop_timing.avg[task] - duration)/16;
+    }
+}
+
+void loop_timing_reset(void) {
+    memset(&loop_timing, 0, sizeof(LoopTiming));
+    for(uint8_t task = 0; task < LOOP_TIMING_TASK_NUM; task++) {
+        loop_timing.min[task] = UINT32_MAX;
+    }
+
+    // A reset can happen in the middle of the main loop (from a message handler)
+    loop_timing.loop_rate_time = system_timer_get_ms();
+    loop_timing.last_cycles    = loop_timing_get_cycles();
+}
@@ -0,0 +1,53 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * loop_timing.h: Execution time measurement of the main loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef LOOP_TIMING_H
+#define LOOP_TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOOP_TIMING_TASK_BOOTLOADER    0
+#define LOOP_TIMING_TASK_COMMUNICATION 1
+#define LOOP_TIMING_TASK_AC_IN         2
+#define LOOP_TIMING_TASK_OUTAGE_LOG    3
+#define LOOP_TIMING_TASK_NUM           4
+
+// All times are in CPU cycles
+typedef struct {
+    uint32_t min[LOOP_TIMING_TASK_NUM];
+    uint32_t avg[LOOP_TIMING_TASK_NUM];
+    uint32_t max[LOOP_TIMING_TASK_NUM];
+
+    uint32_t loop_rate; // main loop iterations per second
+    uint32_t loop_count;
+    uint32_t loop_rate_time;
+
+    uint32_t last_cycles;
+} LoopTiming;
+
+extern LoopTiming loop_timing;
+
+void loop_timing_start(void);
+void loop_timing_measure(const uint8_t task);
+void loop_timing_reset(void);
+
+#endif
@@ -0,0 +1,51 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * low_power.c: Optional sleep of the core between interrupts
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "low_power.h"
+
+#include <string.h>
+
+#include "configs/config.h"
+#include "ac_in.h"
+
+LowPower low_power;
+
+// Called at the end of the main loop. In low power mode the core sleeps until the
+// next interrupt: SysTick (every 1ms), SPITFP (USIC) or an input edge (ERU).
+// Since the SysTick wakes us up at least once per ms, ac_in_tick runs with at most
+// 1ms delay and the detection latency grows by at most 1ms.
+void low_power_sleep(void) {
+    if(!low_power.enabled) {
+        return;
+    }
+
+    // WFI also returns if an interrupt becomes pending while interrupts are disabled.
+    // This way an edge that arrives after the check can't be delayed until the next SysTick.
+    __disable_irq();
+    if((ac_in.irq_edge == 0) && (ac_in.cb_value_immediate_pending == 0)) {
+        __WFI();
+    }
+    __enable_irq();
+}
+
+void low_power_init(void) {
+    memset(&low_power, 0, sizeof(LowPower));
+}
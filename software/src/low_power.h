@@ -0,0 +1,37 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * low_power.h: Optional sleep of the core between interrupts
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef LOW_POWER_H
+#define LOW_POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    bool enabled;
+} LowPower;
+
+extern LowPower low_power;
+
+void low_power_sleep(void);
+void low_power_init(void);
+
+#endif
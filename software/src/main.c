@@ -30,17 +30,30 @@
 #include "communication.h"
 
 #include "ac_in.h"
+#include "loop_timing.h"
+#include "waveform.h"
+#include "outage_log.h"
+#include "low_power.h"
+#include "timestamp.h"
+#include "scheduler.h"
+#include "time_sync.h"
 
 int main(void) {
 	logging_init();
 	logd("Start Industrial Dual AC In Bricklet\n\r");
 
 	communication_init();
+	timestamp_init();
+	outage_log_init();
+	low_power_init();
+	time_sync_init();
 	ac_in_init();
+	waveform_init();
+	scheduler_init();
+	loop_timing_reset();
 
 	while(true) {
-		bootloader_tick();
-		communication_tick();
-		ac_in_tick();
+		scheduler_tick();
+		low_power_sleep();
 	}
 }
@@ -0,0 +1,208 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * outage_log.c: Outage log in the EEPROM
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "outage_log.h"
+
+#include <string.h>
+
+#include "bricklib2/bootloader/bootloader.h"
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/utility/util_definitions.h"
+
+OutageLog outage_log;
+
+static bool outage_log_is_page_valid(const uint32_t *page) {
+    return (page[OUTAGE_LOG_MAGIC_POS] == OUTAGE_LOG_MAGIC) && (page[OUTAGE_LOG_COUNT_POS] <= OUTAGE_LOG_ENTRIES_PER_PAGE);
+}
+
+uint16_t outage_log_get_length(void) {
+    uint16_t length = outage_log.queue_count;
+    for(uint8_t i = 0; i < OUTAGE_LOG_PAGE_NUM; i++) {
+        length += outage_log.count[i];
+    }
+
+    return length;
+}
+
+// Index 0 is the oldest entry. Queued entries are newer than all entries in the EEPROM.
+bool outage_log_get_entry(const uint16_t index, uint8_t *channel, uint32_t *start, uint32_t *duration) {
+    uint16_t offset = index;
+
+    // The page after the newest page is the oldest page
+    for(uint8_t i = 1; i <= OUTAGE_LOG_PAGE_NUM; i++) {
+        const uint8_t page_index = (outage_log.page + i) % OUTAGE_LOG_PAGE_NUM;
+        if(offset >= outage_log.count[page_index]) {
+            offset -= outage_log.count[page_index];
+            continue;
+        }
+
+        uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+        bootloader_read_eeprom_page(OUTAGE_LOG_FIRST_PAGE + page_index, page);
+
+        const uint32_t *entry = &page[OUTAGE_LOG_ENTRY_POS + offset*OUTAGE_LOG_ENTRY_WORDS];
+        *start    = entry[0];
+        *duration = entry[1] & OUTAGE_LOG_DURATION_MAX;
+        *channel  = entry[1] >> 31;
+
+        return true;
+    }
+
+    if(offset < outage_log.queue_count) {
+        *start    = outage_log.queue[offset].start;
+        *duration = outage_log.queue[offset].duration & OUTAGE_LOG_DURATION_MAX;
+        *channel  = outage_log.queue[offset].duration >> 31;
+
+        return true;
+    }
+
+    return false;
+}
+
+// Only queues the entry, it is written to the EEPROM by outage_log_tick
+void outage_log_append(const uint8_t channel, const uint32_t start, const uint32_t duration) {
+    if(outage_log.queue_count >= OUTAGE_LOG_QUEUE_SIZE) {
+        memmove(&outage_log.queue[0], &outage_log.queue[1], (OUTAGE_LOG_QUEUE_SIZE-1)*sizeof(OutageLogEntry));
+        outage_log.queue_count--;
+    }
+
+    OutageLogEntry *entry = &outage_log.queue[outage_log.queue_count];
+    entry->start    = start;
+    entry->duration = (duration > OUTAGE_LOG_DURATION_MAX ? OUTAGE_LOG_DURATION_MAX : duration) | (((uint32_t)channel) << 31);
+    outage_log.queue_count++;
+}
+
+// Writes all queued entries, with one page write per touched page. Since the
+// pages are used as a ring, each page is only written for every second batch on average.
+static void outage_log_flush(void) {
+    uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+    uint8_t queue_index = 0;
+
+    while(queue_index < outage_log.queue_count) {
+        if(outage_log.count[outage_log.page] >= OUTAGE_LOG_ENTRIES_PER_PAGE) {
+            outage_log.page = (outage_log.page + 1) % OUTAGE_LOG_PAGE_NUM;
+            outage_log.sequence++;
+            outage_log.count[outage_log.page] = 0;
+        }
+
+        uint8_t count = outage_log.count[outage_log.page];
+        if(count == 0) {
+            memset(page, 0, EEPROM_PAGE_SIZE);
+        } else {
+            bootloader_read_eeprom_page(OUTAGE_LOG_FIRST_PAGE + outage_log.page, page);
+        }
+
+        while((queue_index < outage_log.queue_count) && (count < OUTAGE_LOG_ENTRIES_PER_PAGE)) {
+            uint32_t *entry = &page[OUTAGE_LOG_ENTRY_POS + count*OUTAGE_LOG_ENTRY_WORDS];
+            entry[0] = outage_log.queue[queue_index].start;
+            entry[1] = outage_log.queue[queue_index].duration;
+            queue_index++;
+            count++;
+        }
+
+        page[OUTAGE_LOG_MAGIC_POS]    = OUTAGE_LOG_MAGIC;
+        page[OUTAGE_LOG_SEQUENCE_POS] = outage_log.sequence;
+        page[OUTAGE_LOG_COUNT_POS]    = count;
+
+        bootloader_write_eeprom_page(OUTAGE_LOG_FIRST_PAGE + outage_log.page, page);
+        outage_log.count[outage_log.page] = count;
+    }
+
+    outage_log.queue_count = 0;
+}
+
+void outage_log_clear(void) {
+    uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+    memset(page, 0, EEPROM_PAGE_SIZE);
+
+    for(uint8_t i = 0; i < OUTAGE_LOG_PAGE_NUM; i++) {
+        // Don't wear out pages that are already empty
+        if(outage_log.count[i] != 0) {
+            bootloader_write_eeprom_page(OUTAGE_LOG_FIRST_PAGE + i, page);
+        }
+    }
+
+    // Keep the flush back-off, clearing doesn't make the next write any cheaper
+    const uint32_t last_flush  = outage_log.last_flush;
+    const uint32_t flush_delay = outage_log.flush_delay;
+    const bool flushed         = outage_log.flushed;
+    memset(&outage_log, 0, sizeof(OutageLog));
+    outage_log.last_flush  = last_flush;
+    outage_log.flush_delay = flush_delay;
+    outage_log.flushed     = flushed;
+}
+
+// Triggers outage_log_tick, so an entry is written in the next main loop iteration
+bool outage_log_is_flush_due(void) {
+    if(outage_log.queue_count == 0) {
+        return false;
+    }
+
+    return !outage_log.flushed || system_timer_is_time_elapsed_ms(outage_log.last_flush, outage_log.flush_delay);
+}
+
+// Called from the main loop, never from ac_in_tick
+void outage_log_tick(void) {
+    if(!outage_log_is_flush_due()) {
+        return;
+    }
+
+    if(outage_log.flushed && !system_timer_is_time_elapsed_ms(outage_log.last_flush, 2*outage_log.flush_delay)) {
+        outage_log.flush_delay = MIN(2*outage_log.flush_delay, OUTAGE_LOG_FLUSH_DELAY_MAX);
+    } else {
+        outage_log.flush_delay = OUTAGE_LOG_FLUSH_DELAY_MIN;
+    }
+
+    outage_log_flush();
+    outage_log.last_flush = system_timer_get_ms();
+    outage_log.flushed    = true;
+}
+
+void outage_log_init(void) {
+    memset(&outage_log, 0, sizeof(OutageLog));
+
+    // The valid page with the highest sequence number has the newest entries.
+    // Only pages that belong to the same ring pass (sequence within the last
+    // OUTAGE_LOG_PAGE_NUM pages) are counted, everything else is stale.
+    uint32_t sequence[OUTAGE_LOG_PAGE_NUM];
+    bool valid[OUTAGE_LOG_PAGE_NUM];
+    bool found = false;
+    for(uint8_t i = 0; i < OUTAGE_LOG_PAGE_NUM; i++) {
+        uint32_t page[EEPROM_PAGE_SIZE/sizeof(uint32_t)];
+        bootloader_read_eeprom_page(OUTAGE_LOG_FIRST_PAGE + i, page);
+
+        valid[i]    = outage_log_is_page_valid(page);
+        sequence[i] = page[OUTAGE_LOG_SEQUENCE_POS];
+        if(valid[i]) {
+            outage_log.count[i] = page[OUTAGE_LOG_COUNT_POS];
+            if(!found || (sequence[i] > outage_log.sequence)) {
+                outage_log.page     = i;
+                outage_log.sequence = sequence[i];
+                found               = true;
+            }
+        }
+    }
+
+    for(uint8_t i = 0; i < OUTAGE_LOG_PAGE_NUM; i++) {
+        if(valid[i] && (outage_log.sequence - sequence[i] >= OUTAGE_LOG_PAGE_NUM)) {
+            outage_log.count[i] = 0;
+        }
+    }
+}
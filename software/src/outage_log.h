@@ -0,0 +1,82 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * outage_log.h: Outage log in the EEPROM
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef OUTAGE_LOG_H
+#define OUTAGE_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// EEPROM page 0 is used by the bootloader and page 1 by the configuration (AC_IN_CONFIG_PAGE).
+// The log uses all other pages as a ring. When all pages are full the oldest page is overwritten.
+#define OUTAGE_LOG_FIRST_PAGE       2
+#define OUTAGE_LOG_PAGE_NUM         2
+
+#define OUTAGE_LOG_MAGIC            0x4F55544C
+#define OUTAGE_LOG_MAGIC_POS        0
+#define OUTAGE_LOG_SEQUENCE_POS     1
+#define OUTAGE_LOG_COUNT_POS        2
+#define OUTAGE_LOG_ENTRY_POS        4
+
+// Entry word 0: Start of the outage (uptime in ms)
+// Entry word 1: Duration in ms (bit 0-30) and channel (bit 31)
+#define OUTAGE_LOG_ENTRY_WORDS      2
+#define OUTAGE_LOG_ENTRIES_PER_PAGE ((EEPROM_PAGE_SIZE/sizeof(uint32_t) - OUTAGE_LOG_ENTRY_POS)/OUTAGE_LOG_ENTRY_WORDS)
+#define OUTAGE_LOG_DURATION_MAX     0x7FFFFFFF
+
+// Every completed outage is logged. New entries are queued in RAM and written by
+// outage_log_tick. A page write blocks the main loop, so the writes back off while
+// the input flaps: The queue is written as soon as the last write is at least
+// flush_delay ago. A write within twice the delay doubles it (up to the maximum),
+// otherwise it starts over at the minimum. Only entries that wait in the queue are
+// lost on a reset. If the queue is full the oldest queued entry is dropped.
+#define OUTAGE_LOG_QUEUE_SIZE       16
+#define OUTAGE_LOG_FLUSH_DELAY_MIN  1000         // in ms
+#define OUTAGE_LOG_FLUSH_DELAY_MAX  (10*60*1000) // in ms
+
+typedef struct {
+    uint32_t start;
+    uint32_t duration; // Duration (bit 0-30) and channel (bit 31), same as in the EEPROM
+} OutageLogEntry;
+
+typedef struct {
+    uint8_t  page;     // Page with the newest entry, relative to OUTAGE_LOG_FIRST_PAGE
+    uint32_t sequence; // Sequence number of that page
+    uint8_t  count[OUTAGE_LOG_PAGE_NUM];
+
+    OutageLogEntry queue[OUTAGE_LOG_QUEUE_SIZE];
+    uint8_t  queue_count;
+    uint32_t last_flush;  // in ms
+    uint32_t flush_delay; // in ms
+    bool     flushed;    // false until the first flush
+} OutageLog;
+
+extern OutageLog outage_log;
+
+uint16_t outage_log_get_length(void);
+bool outage_log_get_entry(const uint16_t index, uint8_t *channel, uint32_t *start, uint32_t *duration);
+void outage_log_append(const uint8_t channel, const uint32_t start, const uint32_t duration);
+void outage_log_clear(void);
+bool outage_log_is_flush_due(void);
+void outage_log_tick(void);
+void outage_log_init(void);
+
+#endif
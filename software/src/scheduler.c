@@ -0,0 +1,92 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * scheduler.c: Deadline based cooperative scheduler for the main loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "scheduler.h"
+
+#include <string.h>
+
+#include "bricklib2/bootloader/bootloader.h"
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "communication.h"
+#include "ac_in.h"
+#include "loop_timing.h"
+#include "outage_log.h"
+#include "timestamp.h"
+
+Scheduler scheduler;
+
+// Time in us until the deadline of the task, negative if it is already overdue
+static inline int32_t scheduler_get_slack(const SchedulerTask *task) {
+    return (int32_t)(task->last_run + task->max_interval - scheduler.time_us);
+}
+
+// Runs all tasks that are due, the task with the earliest deadline first.
+// A task is due if its interval is over or if its trigger fired.
+void scheduler_tick(void) {
+    loop_timing_start();
+
+    scheduler.time_ms = system_timer_get_ms();
+    scheduler.time_us = timestamp_get_us();
+
+    uint8_t due = 0;
+    for(uint8_t i = 0; i < SCHEDULER_TASK_NUM; i++) {
+        const SchedulerTask *task = &scheduler.task[i];
+        if((task->max_interval == 0) ||
+           ((task->is_triggered != NULL) && task->is_triggered()) ||
+           (timestamp_diff_us(task->last_run, scheduler.time_us) >= task->max_interval)) {
+            due |= 1 << i;
+        }
+    }
+
+    while(due != 0) {
+        uint8_t next = 0;
+        int32_t next_slack = INT32_MAX;
+        for(uint8_t i = 0; i < SCHEDULER_TASK_NUM; i++) {
+            if((due & (1 << i)) && (scheduler_get_slack(&scheduler.task[i]) < next_slack)) {
+                next       = i;
+                next_slack = scheduler_get_slack(&scheduler.task[i]);
+            }
+        }
+
+        SchedulerTask *task = &scheduler.task[next];
+        task->tick();
+        task->last_run = scheduler.time_us;
+        loop_timing_measure(task->loop_timing_task);
+
+        due &= ~(1 << next);
+    }
+}
+
+void scheduler_init(void) {
+    memset(&scheduler, 0, sizeof(Scheduler));
+
+    scheduler.time_ms = system_timer_get_ms();
+    scheduler.time_us = timestamp_get_us();
+
+    // The SPITFP stack and the message handling run in every iteration
+    const SchedulerTask task[SCHEDULER_TASK_NUM] = {
+        {bootloader_tick,    NULL,                    0,                             scheduler.time_us, LOOP_TIMING_TASK_BOOTLOADER},
+        {communication_tick, NULL,                    0,                             scheduler.time_us, LOOP_TIMING_TASK_COMMUNICATION},
+        {ac_in_tick,         ac_in_is_tick_pending,   SCHEDULER_AC_IN_MAX_INTERVAL,  scheduler.time_us, LOOP_TIMING_TASK_AC_IN},
+        {outage_log_tick,    outage_log_is_flush_due, SCHEDULER_OUTAGE_LOG_INTERVAL, scheduler.time_us, LOOP_TIMING_TASK_OUTAGE_LOG},
+    };
+    memcpy(scheduler.task, task, sizeof(task));
+}
@@ -0,0 +1,67 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * scheduler.h: Deadline based cooperative scheduler for the main loop
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Maximum interval between two runs of ac_in_tick in us. The guaranteed bound is
+// this interval plus the longest main loop iteration (see get_main_loop_timing).
+#define SCHEDULER_AC_IN_MAX_INTERVAL 1000
+
+// Interval of the outage log task in us. It is triggered as soon as the queued
+// entries are due, so the interval only bounds the time between two checks.
+#define SCHEDULER_OUTAGE_LOG_INTERVAL 1000000
+
+#define SCHEDULER_TASK_NUM 4
+
+typedef struct {
+    void (*tick)(void);
+    bool (*is_triggered)(void); // Optional, the task runs early if it returns true
+    uint32_t max_interval;      // in us, 0 = run in every iteration
+    uint32_t last_run;          // in us
+    uint8_t loop_timing_task;
+} SchedulerTask;
+
+typedef struct {
+    // Time of the current iteration, read once and shared by all tasks
+    uint32_t time_ms;
+    uint32_t time_us;
+
+    SchedulerTask task[SCHEDULER_TASK_NUM];
+} Scheduler;
+
+extern Scheduler scheduler;
+
+static inline uint32_t scheduler_get_ms(void) {
+    return scheduler.time_ms;
+}
+
+static inline uint32_t scheduler_get_us(void) {
+    return scheduler.time_us;
+}
+
+void scheduler_tick(void);
+void scheduler_init(void);
+
+#endif
@@ -0,0 +1,128 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * time_sync.c: Synchronisation of the local timestamp to a host reference time
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "time_sync.h"
+
+#include <string.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "timestamp.h"
+
+TimeSync time_sync;
+
+// Host time at a local time, extrapolated from a point with the current drift.
+// The local time has to be within about 35 minutes of the point.
+static uint64_t time_sync_project(const TimeSyncPoint *point, const uint32_t local) {
+    const int64_t delta = (int32_t)(local - point->local);
+    return point->host + delta + (delta*time_sync.drift)/1000000000LL;
+}
+
+// A point is better if it had a smaller latency, i.e. it gives a later host time
+static bool time_sync_is_better(const TimeSyncPoint *point, const TimeSyncPoint *than) {
+    return (int64_t)(point->host - time_sync_project(than, point->local)) > 0;
+}
+
+// Drift between the oldest anchor and the best point of a finished window. Both are
+// measured points, the drift estimate itself is not used for them. The range is
+// checked before the multiplication, so a jump of the host time can't overflow it.
+static void time_sync_update_drift(const TimeSyncPoint *point) {
+    if((time_sync.anchor_count == 0) || system_timer_is_time_elapsed_ms(time_sync.anchor[time_sync.anchor_newest].local_ms, TIME_SYNC_ANCHOR_INTERVAL)) {
+        time_sync.anchor_newest = (time_sync.anchor_newest + 1) % TIME_SYNC_ANCHOR_NUM;
+        time_sync.anchor[time_sync.anchor_newest] = *point;
+        if(time_sync.anchor_count < TIME_SYNC_ANCHOR_NUM) {
+            time_sync.anchor_count++;
+        }
+    }
+
+    const TimeSyncPoint *anchor = &time_sync.anchor[(time_sync.anchor_newest + TIME_SYNC_ANCHOR_NUM + 1 - time_sync.anchor_count) % TIME_SYNC_ANCHOR_NUM];
+    const uint32_t local_delta  = timestamp_diff_us(anchor->local, point->local);
+    if(local_delta < TIME_SYNC_DRIFT_MIN_BASELINE) {
+        return;
+    }
+
+    const int64_t difference     = (int64_t)(point->host - anchor->host) - (int64_t)local_delta;
+    const int64_t difference_max = ((int64_t)local_delta*TIME_SYNC_DRIFT_MAX_PPM)/1000000;
+    if((difference > difference_max) || (difference < -difference_max)) {
+        return;
+    }
+
+    const int32_t drift = (int32_t)((difference*1000000000LL)/(int64_t)local_delta);
+    if(time_sync.drift_valid) {
+        time_sync.drift += (drift - time_sync.drift)/TIME_SYNC_DRIFT_FILTER;
+    } else {
+        time_sync.drift       = drift;
+        time_sync.drift_valid = true;
+    }
+}
+
+// Called with the host time at the moment the host sent the message
+void time_sync_set_reference(const uint64_t host_time) {
+    const TimeSyncPoint sample = {
+        .local    = timestamp_get_us(),
+        .local_ms = system_timer_get_ms(),
+        .host     = host_time
+    };
+
+    time_sync.sync_count++;
+
+    bool restart = !time_sync.synced || system_timer_is_time_elapsed_ms(time_sync.reference.local_ms, TIME_SYNC_REFERENCE_MAX_AGE);
+    if(!restart) {
+        const int64_t error = (int64_t)(host_time - time_sync_project(&time_sync.reference, sample.local));
+        restart = (error > TIME_SYNC_STEP_MAX) || (error < -TIME_SYNC_STEP_MAX);
+    }
+
+    if(restart) {
+        time_sync.reference    = sample;
+        time_sync.window_best  = sample;
+        time_sync.window_start = sample.local_ms;
+        time_sync.anchor_count = 0;
+        time_sync.synced       = true;
+        return;
+    }
+
+    if(system_timer_is_time_elapsed_ms(time_sync.window_start, TIME_SYNC_WINDOW)) {
+        time_sync.reference = time_sync.window_best;
+        time_sync_update_drift(&time_sync.window_best);
+
+        time_sync.window_best  = sample;
+        time_sync.window_start = sample.local_ms;
+    } else if(time_sync_is_better(&sample, &time_sync.window_best)) {
+        time_sync.window_best = sample;
+    }
+
+    if(time_sync_is_better(&time_sync.window_best, &time_sync.reference)) {
+        time_sync.reference = time_sync.window_best;
+    }
+}
+
+// Host time in us for a local us timestamp, e.g. from the event stream or the recorder.
+// Only valid for timestamps within about 35 minutes of the reference.
+uint64_t time_sync_get_synced(const uint32_t local_time) {
+    if(!time_sync.synced) {
+        return 0;
+    }
+
+    return time_sync_project(&time_sync.reference, local_time);
+}
+
+void time_sync_init(void) {
+    memset(&time_sync, 0, sizeof(TimeSync));
+}
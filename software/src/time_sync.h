@@ -0,0 +1,85 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * time_sync.h: Synchronisation of the local timestamp to a host reference time
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Each reference from the host arrives with a transfer latency of its own. The host time
+// is taken before sending, so the reference with the smallest latency gives the largest
+// host time for the same local time (min-latency filter). The best reference of each
+// window is used as a point for the conversion and the drift measurement.
+#define TIME_SYNC_WINDOW                (16*1000) // in ms
+
+// The drift is measured between the newest point and an anchor point that is at least
+// the minimum baseline older, so the latency jitter is small compared to the baseline.
+// A new anchor is taken every interval and the older of the two anchors is used.
+// This keeps the baseline below the 35 minutes in which us timestamp differences are valid.
+#define TIME_SYNC_DRIFT_MIN_BASELINE    (60*1000000) // in us
+#define TIME_SYNC_ANCHOR_INTERVAL       (10*60*1000) // in ms
+#define TIME_SYNC_ANCHOR_NUM            2
+
+// A point that is older than this can't be used anymore, the synchronisation starts over
+#define TIME_SYNC_REFERENCE_MAX_AGE     (20*60*1000) // in ms
+
+// The local time base runs from the internal oscillator, larger measurements are not plausible
+#define TIME_SYNC_DRIFT_MAX_PPM         30000
+
+// Weight of a new drift measurement is 1/TIME_SYNC_DRIFT_FILTER
+#define TIME_SYNC_DRIFT_FILTER          4
+
+// A reference that is further away from the estimate means that the host clock was set,
+// the synchronisation starts over. The drift is kept.
+#define TIME_SYNC_STEP_MAX              500000 // in us
+
+typedef struct {
+    uint32_t local;    // in us
+    uint32_t local_ms; // for the age
+    uint64_t host;     // in us
+} TimeSyncPoint;
+
+typedef struct {
+    bool     synced;
+    uint32_t sync_count;
+
+    // Point that is used for the conversion, the best of the last two windows
+    TimeSyncPoint reference;
+
+    TimeSyncPoint window_best;
+    uint32_t window_start; // in ms
+
+    TimeSyncPoint anchor[TIME_SYNC_ANCHOR_NUM];
+    uint8_t  anchor_count;
+    uint8_t  anchor_newest;
+
+    int32_t  drift; // in ppb, positive if the host clock is faster
+    bool     drift_valid;
+} TimeSync;
+
+extern TimeSync time_sync;
+
+void time_sync_set_reference(const uint64_t host_time);
+uint64_t time_sync_get_synced(const uint32_t local_time);
+void time_sync_init(void);
+
+#endif
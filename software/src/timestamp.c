@@ -0,0 +1,60 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * timestamp.c: Free running microsecond time base
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "timestamp.h"
+
+// Has to be called before all other modules that use CCU40
+void timestamp_init(void) {
+    const XMC_CCU4_SLICE_COMPARE_CONFIG_t timer_low_config = {
+        .timer_mode          = XMC_CCU4_SLICE_TIMER_COUNT_MODE_EA,
+        .monoshot            = XMC_CCU4_SLICE_TIMER_REPEAT_MODE_REPEAT,
+        .shadow_xfer_clear   = false,
+        .dither_timer_period = false,
+        .dither_duty_cycle   = false,
+        .prescaler_mode      = XMC_CCU4_SLICE_PRESCALER_MODE_NORMAL,
+        .mcm_enable          = false,
+        .prescaler_initval   = TIMESTAMP_PRESCALER,
+        .float_limit         = 0,
+        .dither_limit        = 0,
+        .passive_level       = 0,
+        .timer_concatenation = false
+    };
+
+    // The high slice counts the period matches of the low slice
+    XMC_CCU4_SLICE_COMPARE_CONFIG_t timer_high_config = timer_low_config;
+    timer_high_config.timer_concatenation = true;
+
+    XMC_CCU4_Init(TIMESTAMP_CCU4, XMC_CCU4_SLICE_MCMS_ACTION_TRANSFER_PR_CR);
+    XMC_CCU4_StartPrescaler(TIMESTAMP_CCU4);
+
+    XMC_CCU4_SLICE_CompareInit(TIMESTAMP_SLICE_LOW, &timer_low_config);
+    XMC_CCU4_SLICE_CompareInit(TIMESTAMP_SLICE_HIGH, &timer_high_config);
+    XMC_CCU4_SLICE_SetTimerPeriodMatch(TIMESTAMP_SLICE_LOW, 0xFFFF);
+    XMC_CCU4_SLICE_SetTimerPeriodMatch(TIMESTAMP_SLICE_HIGH, 0xFFFF);
+    XMC_CCU4_SLICE_SetTimerCompareMatch(TIMESTAMP_SLICE_LOW, 0);
+    XMC_CCU4_SLICE_SetTimerCompareMatch(TIMESTAMP_SLICE_HIGH, 0);
+    XMC_CCU4_EnableShadowTransfer(TIMESTAMP_CCU4, XMC_CCU4_SHADOW_TRANSFER_SLICE_0 | XMC_CCU4_SHADOW_TRANSFER_SLICE_1);
+
+    XMC_CCU4_EnableClock(TIMESTAMP_CCU4, TIMESTAMP_SLICE_LOW_NUM);
+    XMC_CCU4_EnableClock(TIMESTAMP_CCU4, TIMESTAMP_SLICE_HIGH_NUM);
+    XMC_CCU4_SLICE_StartTimer(TIMESTAMP_SLICE_HIGH);
+    XMC_CCU4_SLICE_StartTimer(TIMESTAMP_SLICE_LOW);
+}
@@ -0,0 +1,60 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * timestamp.h: Free running microsecond time base
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "configs/config_timestamp.h"
+
+// Time since start-up in us, wraps around after about 71.6 minutes.
+// Differences between two timestamps are correct across the wraparound
+// as long as the timestamps are less than 2^31 us (about 35 minutes) apart.
+static inline uint32_t timestamp_get_us(void) {
+    // Re-read the low half if the high half changed in between
+    uint16_t high = XMC_CCU4_SLICE_GetTimerValue(TIMESTAMP_SLICE_HIGH);
+    uint16_t low  = XMC_CCU4_SLICE_GetTimerValue(TIMESTAMP_SLICE_LOW);
+    const uint16_t high_check = XMC_CCU4_SLICE_GetTimerValue(TIMESTAMP_SLICE_HIGH);
+    if(high != high_check) {
+        high = high_check;
+        low  = XMC_CCU4_SLICE_GetTimerValue(TIMESTAMP_SLICE_LOW);
+    }
+
+    return (((uint32_t)high) << 16) | low;
+}
+
+static inline uint32_t timestamp_diff_us(const uint32_t start, const uint32_t end) {
+    return end - start;
+}
+
+static inline bool timestamp_is_before(const uint32_t a, const uint32_t b) {
+    return ((int32_t)(a - b)) < 0;
+}
+
+static inline bool timestamp_is_time_elapsed_us(const uint32_t start, const uint32_t time) {
+    return timestamp_diff_us(start, timestamp_get_us()) >= time;
+}
+
+void timestamp_init(void);
+
+#endif
@@ -0,0 +1,95 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * waveform.c: Raw waveform capture of the opto outputs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "waveform.h"
+
+#include <string.h>
+
+#include "configs/config_ac_in.h"
+#include "ac_in.h"
+#include "communication.h"
+
+Waveform waveform;
+
+#define waveform_irq_handler IRQ_Hdlr_23
+
+void __attribute__((optimize("-O3"))) __attribute__ ((section (".ram_code"))) waveform_irq_handler(void) {
+    const uint8_t input  = (AC_IN_INPUT_PORT->IN >> AC_IN_INPUT_SHIFT) & AC_IN_CHANNEL_MASK;
+    const uint16_t count = waveform.sample_count;
+
+    // The buffer is cleared on start, so we only have to set the bits
+    waveform.buffer[count/WAVEFORM_SAMPLES_PER_BYTE] |= input << ((count % WAVEFORM_SAMPLES_PER_BYTE)*AC_IN_CHANNEL_NUM);
+    waveform.sample_count = count + 1;
+
+    if(waveform.sample_count >= WAVEFORM_SAMPLE_NUM) {
+        XMC_CCU4_SLICE_StopTimer(WAVEFORM_TIMER_SLICE);
+        waveform.state = INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_DONE;
+    }
+
+    XMC_CCU4_SLICE_ClearEvent(WAVEFORM_TIMER_SLICE, XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH);
+}
+
+// Starts a new capture, a running capture is discarded
+void waveform_start(const uint16_t sample_period) {
+    XMC_CCU4_SLICE_StopTimer(WAVEFORM_TIMER_SLICE);
+    XMC_CCU4_SLICE_ClearTimer(WAVEFORM_TIMER_SLICE);
+    NVIC_ClearPendingIRQ(WAVEFORM_IRQ);
+
+    memset(waveform.buffer, 0, WAVEFORM_BUFFER_SIZE);
+    waveform.sample_count  = 0;
+    waveform.sample_period = sample_period;
+    waveform.stream_offset = 0;
+    waveform.state         = INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_RUNNING;
+
+    XMC_CCU4_SLICE_SetTimerPeriodMatch(WAVEFORM_TIMER_SLICE, sample_period - 1);
+    XMC_CCU4_EnableShadowTransfer(WAVEFORM_TIMER_CCU4, XMC_CCU4_SHADOW_TRANSFER_SLICE_2);
+    XMC_CCU4_SLICE_StartTimer(WAVEFORM_TIMER_SLICE);
+}
+
+// Has to be called after timestamp_init, the CCU40 module is initialized there
+void waveform_init(void) {
+    memset(&waveform, 0, sizeof(Waveform));
+    waveform.state = INDUSTRIAL_DUAL_AC_IN_WAVEFORM_STATE_IDLE;
+
+    const XMC_CCU4_SLICE_COMPARE_CONFIG_t timer_config = {
+        .timer_mode          = XMC_CCU4_SLICE_TIMER_COUNT_MODE_EA,
+        .monoshot            = XMC_CCU4_SLICE_TIMER_REPEAT_MODE_REPEAT,
+        .shadow_xfer_clear   = false,
+        .dither_timer_period = false,
+        .dither_duty_cycle   = false,
+        .prescaler_mode      = XMC_CCU4_SLICE_PRESCALER_MODE_NORMAL,
+        .mcm_enable          = false,
+        .prescaler_initval   = WAVEFORM_TIMER_PRESCALER,
+        .float_limit         = 0,
+        .dither_limit        = 0,
+        .passive_level       = 0,
+        .timer_concatenation = false
+    };
+
+    XMC_CCU4_SLICE_CompareInit(WAVEFORM_TIMER_SLICE, &timer_config);
+    XMC_CCU4_SLICE_SetTimerCompareMatch(WAVEFORM_TIMER_SLICE, 0);
+    XMC_CCU4_SLICE_EnableEvent(WAVEFORM_TIMER_SLICE, XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH);
+    XMC_CCU4_SLICE_SetInterruptNode(WAVEFORM_TIMER_SLICE, XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH, XMC_CCU4_SLICE_SR_ID_2);
+    XMC_CCU4_EnableClock(WAVEFORM_TIMER_CCU4, WAVEFORM_TIMER_SLICE_NUM);
+
+    NVIC_SetPriority(WAVEFORM_IRQ, WAVEFORM_IRQ_PRIORITY);
+    NVIC_EnableIRQ(WAVEFORM_IRQ);
+}
@@ -0,0 +1,53 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * waveform.h: Raw waveform capture of the opto outputs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// One bit per channel per sample, CH0 sample n is bit 2n of the buffer, CH1 sample n is bit 2n+1
+#define WAVEFORM_BUFFER_SIZE       1024
+#define WAVEFORM_SAMPLES_PER_BYTE  4
+#define WAVEFORM_SAMPLE_NUM        (WAVEFORM_BUFFER_SIZE*WAVEFORM_SAMPLES_PER_BYTE)
+
+// in us
+#define WAVEFORM_SAMPLE_PERIOD_MIN 50
+#define WAVEFORM_SAMPLE_PERIOD_MAX 65535
+
+#define WAVEFORM_CHUNK_SIZE        60 // in bytes
+
+typedef struct {
+    volatile uint8_t  state;
+    volatile uint16_t sample_count;
+    uint16_t sample_period;
+    uint16_t stream_offset; // in bits, next chunk of the low level getter
+
+    uint8_t buffer[WAVEFORM_BUFFER_SIZE];
+} Waveform;
+
+extern Waveform waveform;
+
+void waveform_start(const uint16_t sample_period);
+void waveform_init(void);
+
+#endif
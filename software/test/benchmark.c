@@ -0,0 +1,569 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * benchmark.c: Detection latency benchmark, replays waveform files on the simulation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+// Usage: benchmark <result.json> <waveform file>...
+//
+// Every waveform file is one scenario for channel 0. The file has one
+// segment or setting per line, "#" starts a comment:
+//
+//   ac <frequency in Hz> <duration in ms> [on-time in %]  AC voltage, square wave at the opto output
+//   off <duration in ms> [high|low]                         No AC, constant input level (default high)
+//   drop <pulses>                                           The next <pulses> opto pulses are missing
+//   bounce <pulses> <pulse width in us> <gap in us>         Contact bounce, short pulses
+//   repeat <count> ... end                                  Repeats the enclosed lines
+//   jitter <us>                                             Adds 0 to <us> to every following duration
+//   detection <fixed|adaptive> <timeout in ms> <missed edges>
+//   filter <min pulse width in us> <min edges>
+//   low_power <on|off>
+//
+// AC is present during ac and drop, and absent during off. A bounce belongs
+// to the segment after it, so switching on starts with the first bounce pulse.
+// The detection latency is the time from a change of the presence to the
+// immediate value callback that reports it. Every other reported change is a
+// false positive, a change that is not reported before the next one is missed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "communication.h"
+
+#define BENCHMARK_SETTLE_TIME 200000 // in us, the value starts with the input level
+#define BENCHMARK_LINE_SIZE   256
+#define BENCHMARK_REPEAT_NUM  8      // Maximum nesting of repeat blocks
+
+typedef enum {
+    SEGMENT_AC,
+    SEGMENT_OFF,
+    SEGMENT_DROP,
+    SEGMENT_BOUNCE,
+    SEGMENT_JITTER,
+    SEGMENT_DETECTION,
+    SEGMENT_FILTER,
+    SEGMENT_LOW_POWER
+} SegmentType;
+
+typedef struct {
+    SegmentType type;
+    uint32_t arg[4];
+    bool present; // Presence during this segment
+} Segment;
+
+typedef struct {
+    uint64_t *data;
+    size_t count;
+    size_t size;
+} Array;
+
+typedef struct {
+    uint64_t time; // in us
+    bool present;
+} Transition;
+
+typedef struct {
+    Segment *segment;
+    size_t segment_count;
+    size_t segment_size;
+
+    // Ground truth and reported value changes of the current run
+    Transition *transition;
+    size_t transition_count;
+    size_t transition_size;
+    Transition *report;
+    size_t report_count;
+    size_t report_size;
+    uint32_t callback_count;
+
+    // Waveform generator
+    uint64_t cursor;
+    uint64_t next_edge;
+    bool     running;
+    uint32_t period;
+    uint32_t on_time;
+    uint32_t jitter;
+    uint32_t random;
+} Benchmark;
+
+static Benchmark benchmark;
+
+static void *benchmark_grow(void *data, size_t *size, const size_t count, const size_t element_size) {
+    if(count < *size) {
+        return data;
+    }
+
+    *size = (*size == 0) ? 64 : *size*2;
+    data  = realloc(data, *size*element_size);
+    if(data == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+
+    return data;
+}
+
+static void array_push(Array *array, const uint64_t value) {
+    array->data = benchmark_grow(array->data, &array->size, array->count, sizeof(uint64_t));
+    array->data[array->count++] = value;
+}
+
+static int array_compare(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t*)a;
+    const uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile, the array has to be sorted
+static uint64_t array_percentile(const Array *array, const uint32_t percent) {
+    if(array->count == 0) {
+        return 0;
+    }
+
+    size_t rank = (array->count*percent + 99)/100;
+    return array->data[rank == 0 ? 0 : rank - 1];
+}
+
+static void segment_push(const Segment *segment) {
+    benchmark.segment = benchmark_grow(benchmark.segment, &benchmark.segment_size, benchmark.segment_count, sizeof(Segment));
+    benchmark.segment[benchmark.segment_count++] = *segment;
+}
+
+static void transition_push(Transition **list, size_t *count, size_t *size, const uint64_t time, const bool present) {
+    *list = benchmark_grow(*list, size, *count, sizeof(Transition));
+    (*list)[*count].time    = time;
+    (*list)[*count].present = present;
+    (*count)++;
+}
+
+static bool parse_error(const char *file, const uint32_t line, const char *message) {
+    fprintf(stderr, "%s:%u: %s\n", file, line, message);
+    return false;
+}
+
+static bool benchmark_parse(const char *file) {
+    FILE *f = fopen(file, "r");
+    if(f == NULL) {
+        fprintf(stderr, "Could not open %s\n", file);
+        return false;
+    }
+
+    size_t   repeat_start[BENCHMARK_REPEAT_NUM];
+    uint32_t repeat_count[BENCHMARK_REPEAT_NUM];
+    uint8_t  repeat_depth = 0;
+
+    char text[BENCHMARK_LINE_SIZE];
+    uint32_t line = 0;
+    benchmark.segment_count = 0;
+
+    while(fgets(text, sizeof(text), f) != NULL) {
+        line++;
+
+        char *comment = strchr(text, '#');
+        if(comment != NULL) {
+            *comment = '\0';
+        }
+
+        char command[32] = "";
+        char option[32]  = "";
+        double value     = 0;
+        uint32_t a = 0, b = 0, c = 0;
+        if(sscanf(text, "%31s", command) != 1) {
+            continue;
+        }
+
+        Segment segment;
+        memset(&segment, 0, sizeof(Segment));
+
+        if(strcmp(command, "ac") == 0) {
+            const int n = sscanf(text, "%*s %lf %u %u", &value, &a, &b);
+            if((n < 2) || (value <= 0) || (n == 3 && (b == 0 || b >= 100))) {
+                fclose(f);
+                return parse_error(file, line, "expected: ac <frequency in Hz> <duration in ms> [on-time in %]");
+            }
+            segment.type    = SEGMENT_AC;
+            segment.arg[0]  = (uint32_t)(1000000.0/value + 0.5);
+            segment.arg[1]  = a*1000;
+            segment.arg[2]  = (n == 3) ? b : 50;
+            segment.present = true;
+        } else if(strcmp(command, "off") == 0) {
+            const int n = sscanf(text, "%*s %u %31s", &a, option);
+            if((n < 1) || (n == 2 && strcmp(option, "high") != 0 && strcmp(option, "low") != 0)) {
+                fclose(f);
+                return parse_error(file, line, "expected: off <duration in ms> [high|low]");
+            }
+            segment.type    = SEGMENT_OFF;
+            segment.arg[0]  = a*1000;
+            segment.arg[1]  = (n == 2) && (strcmp(option, "low") == 0) ? 0 : 1;
+            segment.present = false;
+        } else if(strcmp(command, "drop") == 0) {
+            if(sscanf(text, "%*s %u", &a) != 1) {
+                fclose(f);
+                return parse_error(file, line, "expected: drop <pulses>");
+            }
+            segment.type    = SEGMENT_DROP;
+            segment.arg[0]  = a;
+            segment.present = true;
+        } else if(strcmp(command, "bounce") == 0) {
+            if(sscanf(text, "%*s %u %u %u", &a, &b, &c) != 3) {
+                fclose(f);
+                return parse_error(file, line, "expected: bounce <pulses> <pulse width in us> <gap in us>");
+            }
+            segment.type   = SEGMENT_BOUNCE;
+            segment.arg[0] = a;
+            segment.arg[1] = b;
+            segment.arg[2] = c;
+        } else if(strcmp(command, "jitter") == 0) {
+            if(sscanf(text, "%*s %u", &a) != 1) {
+                fclose(f);
+                return parse_error(file, line, "expected: jitter <us>");
+            }
+            segment.type   = SEGMENT_JITTER;
+            segment.arg[0] = a;
+        } else if(strcmp(command, "detection") == 0) {
+            if((sscanf(text, "%*s %31s %u %u", option, &a, &b) != 3) || (strcmp(option, "fixed") != 0 && strcmp(option, "adaptive") != 0)) {
+                fclose(f);
+                return parse_error(file, line, "expected: detection <fixed|adaptive> <timeout in ms> <missed edges>");
+            }
+            segment.type   = SEGMENT_DETECTION;
+            segment.arg[0] = strcmp(option, "adaptive") == 0 ? INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE : INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_FIXED;
+            segment.arg[1] = a;
+            segment.arg[2] = b;
+        } else if(strcmp(command, "filter") == 0) {
+            if(sscanf(text, "%*s %u %u", &a, &b) != 2) {
+                fclose(f);
+                return parse_error(file, line, "expected: filter <min pulse width in us> <min edges>");
+            }
+            segment.type   = SEGMENT_FILTER;
+            segment.arg[0] = a;
+            segment.arg[1] = b;
+        } else if(strcmp(command, "low_power") == 0) {
+            if((sscanf(text, "%*s %31s", option) != 1) || (strcmp(option, "on") != 0 && strcmp(option, "off") != 0)) {
+                fclose(f);
+                return parse_error(file, line, "expected: low_power <on|off>");
+            }
+            segment.type   = SEGMENT_LOW_POWER;
+            segment.arg[0] = strcmp(option, "on") == 0;
+        } else if(strcmp(command, "repeat") == 0) {
+            if((sscanf(text, "%*s %u", &a) != 1) || (a == 0) || (repeat_depth >= BENCHMARK_REPEAT_NUM)) {
+                fclose(f);
+                return parse_error(file, line, "expected: repeat <count>, at most 8 levels");
+            }
+            repeat_start[repeat_depth] = benchmark.segment_count;
+            repeat_count[repeat_depth] = a;
+            repeat_depth++;
+            continue;
+        } else if(strcmp(command, "end") == 0) {
+            if(repeat_depth == 0) {
+                fclose(f);
+                return parse_error(file, line, "end without repeat");
+            }
+            repeat_depth--;
+            const size_t start = repeat_start[repeat_depth];
+            const size_t end   = benchmark.segment_count;
+            for(uint32_t i = 1; i < repeat_count[repeat_depth]; i++) {
+                for(size_t j = start; j < end; j++) {
+                    segment_push(&benchmark.segment[j]);
+                }
+            }
+            continue;
+        } else {
+            fclose(f);
+            return parse_error(file, line, "unknown command");
+        }
+
+        segment_push(&segment);
+    }
+    fclose(f);
+
+    if(repeat_depth != 0) {
+        return parse_error(file, line, "repeat without end");
+    }
+
+    // A bounce has the presence of the next segment with a duration
+    bool present = false;
+    for(size_t i = benchmark.segment_count; i > 0; i--) {
+        Segment *segment = &benchmark.segment[i - 1];
+        if((segment->type == SEGMENT_AC) || (segment->type == SEGMENT_OFF)) {
+            present = segment->present;
+        } else if(segment->type == SEGMENT_BOUNCE) {
+            segment->present = present;
+        }
+    }
+
+    return true;
+}
+
+static uint32_t benchmark_jitter(void) {
+    if(benchmark.jitter == 0) {
+        return 0;
+    }
+
+    // Fixed seed, the results only change if the firmware changes
+    benchmark.random = benchmark.random*1103515245 + 12345;
+    return (benchmark.random >> 8) % (benchmark.jitter + 1);
+}
+
+static void benchmark_edge(const uint64_t time, const bool level) {
+    sim_run_to(time);
+    sim_set_input(0, level);
+}
+
+static void benchmark_set_present(const bool present) {
+    if((benchmark.transition_count == 0) || (benchmark.transition[benchmark.transition_count - 1].present != present)) {
+        transition_push(&benchmark.transition, &benchmark.transition_count, &benchmark.transition_size, benchmark.cursor, present);
+    }
+}
+
+static void benchmark_message_handler(const uint64_t time_us, const uint8_t *data, const uint8_t length) {
+    benchmark.callback_count++;
+
+    const Value_Callback *cb = (const Value_Callback*)data;
+    if((length == sizeof(Value_Callback)) && (cb->header.fid == FID_CALLBACK_VALUE) && (cb->channel == 0) && cb->changed) {
+        transition_push(&benchmark.report, &benchmark.report_count, &benchmark.report_size, time_us, cb->value);
+    }
+}
+
+static void benchmark_segment(const Segment *segment) {
+    switch(segment->type) {
+        case SEGMENT_AC: {
+            benchmark_set_present(true);
+            benchmark.period  = segment->arg[0];
+            benchmark.on_time = segment->arg[0]*segment->arg[2]/100;
+            if(!benchmark.running) {
+                benchmark.next_edge = benchmark.cursor;
+                benchmark.running   = true;
+            }
+
+            const uint64_t end = benchmark.cursor + segment->arg[1] + benchmark_jitter();
+            while(benchmark.next_edge < end) {
+                // The opto conducts (input low) for the on-time
+                const bool level = !sim_get_input(0);
+                benchmark_edge(benchmark.next_edge, level);
+                benchmark.next_edge += level ? (benchmark.period - benchmark.on_time) : benchmark.on_time;
+            }
+            benchmark.cursor = end;
+            break;
+        }
+
+        case SEGMENT_OFF: {
+            benchmark_set_present(false);
+            benchmark.running = false;
+            if(sim_get_input(0) != segment->arg[1]) {
+                benchmark_edge(benchmark.cursor, segment->arg[1]);
+            }
+            benchmark.cursor += segment->arg[0] + benchmark_jitter();
+            break;
+        }
+
+        case SEGMENT_DROP: {
+            if(!benchmark.running) {
+                break;
+            }
+            benchmark.next_edge += (uint64_t)segment->arg[0]*benchmark.period;
+            break;
+        }
+
+        case SEGMENT_BOUNCE: {
+            benchmark_set_present(segment->present);
+            benchmark.running = false;
+            const bool level = sim_get_input(0);
+            for(uint32_t i = 0; i < segment->arg[0]; i++) {
+                benchmark_edge(benchmark.cursor, !level);
+                benchmark_edge(benchmark.cursor + segment->arg[1], level);
+                benchmark.cursor += segment->arg[1] + segment->arg[2];
+            }
+            break;
+        }
+
+        case SEGMENT_JITTER: {
+            benchmark.jitter = segment->arg[0];
+            break;
+        }
+
+        case SEGMENT_DETECTION: {
+            SetDetectionConfiguration request = {.channel = 0, .mode = segment->arg[0], .timeout = segment->arg[1], .missed_edges = segment->arg[2]};
+            if(sim_request(&request, sizeof(request), FID_SET_DETECTION_CONFIGURATION, NULL) != HANDLE_MESSAGE_RESPONSE_EMPTY) {
+                fprintf(stderr, "Invalid detection configuration\n");
+            }
+            break;
+        }
+
+        case SEGMENT_FILTER: {
+            SetFilterConfiguration request = {.channel = 0, .min_pulse_width = segment->arg[0], .min_edges = segment->arg[1]};
+            if(sim_request(&request, sizeof(request), FID_SET_FILTER_CONFIGURATION, NULL) != HANDLE_MESSAGE_RESPONSE_EMPTY) {
+                fprintf(stderr, "Invalid filter configuration\n");
+            }
+            break;
+        }
+
+        case SEGMENT_LOW_POWER: {
+            SetLowPowerMode request = {.enabled = segment->arg[0]};
+            sim_request(&request, sizeof(request), FID_SET_LOW_POWER_MODE, NULL);
+            break;
+        }
+    }
+}
+
+static void benchmark_write_latency(FILE *f, const char *name, Array *latency, const bool last) {
+    fprintf(f, "        \"%s\": {\"count\": %zu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}%s\n",
+            name, latency->count,
+            (unsigned long long)array_percentile(latency, 50),
+            (unsigned long long)array_percentile(latency, 99),
+            (unsigned long long)(latency->count == 0 ? 0 : latency->data[latency->count - 1]),
+            last ? "" : ",");
+}
+
+static void benchmark_print_latency(const Array *latency) {
+    printf(" %8.3f %8.3f %8.3f",
+           array_percentile(latency, 50)/1000.0,
+           array_percentile(latency, 99)/1000.0,
+           (latency->count == 0 ? 0 : latency->data[latency->count - 1])/1000.0);
+}
+
+static const char *benchmark_get_name(const char *file) {
+    const char *name = strrchr(file, '/');
+    return name == NULL ? file : name + 1;
+}
+
+static void benchmark_run(FILE *f, const char *file, const bool first) {
+    sim.message_handler = benchmark_message_handler;
+    sim_init(0);
+    sim_run(BENCHMARK_SETTLE_TIME);
+
+    SetImmediateValueCallbackConfiguration request = {.channel = 0, .enabled = true};
+    sim_request(&request, sizeof(request), FID_SET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION, NULL);
+
+    benchmark.transition_count = 0;
+    benchmark.report_count     = 0;
+    benchmark.callback_count   = 0;
+    benchmark.cursor           = sim.time_us;
+    benchmark.running          = false;
+    benchmark.jitter           = 0;
+    benchmark.random           = 1;
+
+    // The channel is absent after the settle time, that is the first known state
+    const uint64_t start = sim.time_us;
+    benchmark_set_present(false);
+    for(size_t i = 0; i < benchmark.segment_count; i++) {
+        benchmark_segment(&benchmark.segment[i]);
+    }
+    sim_run_to(benchmark.cursor);
+
+    // Every reported change is matched to the newest transition before it.
+    // It is a detection if the value matches that transition and it was not reported yet.
+    Array latency_all    = {NULL, 0, 0};
+    Array latency_appear = {NULL, 0, 0};
+    Array latency_loss   = {NULL, 0, 0};
+    uint32_t false_positives = 0;
+    uint32_t detections      = 0;
+    size_t transition        = 0;
+    bool detected            = true; // The initial state is not a transition
+
+    for(size_t i = 0; i < benchmark.report_count; i++) {
+        const Transition *report = &benchmark.report[i];
+        while((transition + 1 < benchmark.transition_count) && (benchmark.transition[transition + 1].time <= report->time)) {
+            transition++;
+            detected = false;
+        }
+
+        if(!detected && (report->present == benchmark.transition[transition].present)) {
+            const uint64_t latency = report->time - benchmark.transition[transition].time;
+            array_push(&latency_all, latency);
+            array_push(report->present ? &latency_appear : &latency_loss, latency);
+            detected = true;
+            detections++;
+        } else {
+            false_positives++;
+        }
+    }
+
+    const uint32_t transitions = benchmark.transition_count - 1;
+    qsort(latency_all.data, latency_all.count, sizeof(uint64_t), array_compare);
+    qsort(latency_appear.data, latency_appear.count, sizeof(uint64_t), array_compare);
+    qsort(latency_loss.data, latency_loss.count, sizeof(uint64_t), array_compare);
+
+    fprintf(f, "%s    {\n", first ? "" : ",\n");
+    fprintf(f, "      \"name\": \"%s\",\n", benchmark_get_name(file));
+    fprintf(f, "      \"duration_ms\": %llu,\n", (unsigned long long)((benchmark.cursor - start)/1000));
+    fprintf(f, "      \"transitions\": %u,\n", transitions);
+    fprintf(f, "      \"detections\": %u,\n", detections);
+    fprintf(f, "      \"missed\": %u,\n", transitions - detections);
+    fprintf(f, "      \"false_positives\": %u,\n", false_positives);
+    fprintf(f, "      \"callbacks\": %u,\n", benchmark.callback_count);
+    fprintf(f, "      \"latency_us\": {\n");
+    benchmark_write_latency(f, "all", &latency_all, false);
+    benchmark_write_latency(f, "appear", &latency_appear, false);
+    benchmark_write_latency(f, "loss", &latency_loss, true);
+    fprintf(f, "      }\n");
+    fprintf(f, "    }");
+
+    printf("%-24s %6u %6u %6u %6u %8u", benchmark_get_name(file), transitions, detections, transitions - detections, false_positives, benchmark.callback_count);
+    benchmark_print_latency(&latency_appear);
+    benchmark_print_latency(&latency_loss);
+    printf("\n");
+
+    free(latency_all.data);
+    free(latency_appear.data);
+    free(latency_loss.data);
+}
+
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        fprintf(stderr, "Usage: %s <result.json> <waveform file>...\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[1], "w");
+    if(f == NULL) {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 2;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"firmware_version\": \"%d.%d.%d\",\n", FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR, FIRMWARE_VERSION_REVISION);
+    fprintf(f, "  \"loop_interval_us\": %d,\n", SIM_LOOP_INTERVAL_DEFAULT);
+    fprintf(f, "  \"scenarios\": [\n");
+
+    printf("%-24s %6s %6s %6s %6s %8s %26s %26s\n", "", "", "", "", "", "", "appear latency [ms]", "loss latency [ms]");
+    printf("%-24s %6s %6s %6s %6s %8s %8s %8s %8s %8s %8s %8s\n", "scenario", "trans", "det", "missed", "fp", "callback", "p50", "p99", "max", "p50", "p99", "max");
+
+    int ret = 0;
+    bool first = true;
+    for(int i = 2; i < argc; i++) {
+        if(!benchmark_parse(argv[i])) {
+            ret = 1;
+            continue;
+        }
+
+        benchmark_run(f, argv[i], first);
+        first = false;
+    }
+
+    fprintf(f, "\n  ]\n");
+    fprintf(f, "}\n");
+    fclose(f);
+
+    free(benchmark.segment);
+    free(benchmark.transition);
+    free(benchmark.report);
+
+    return ret;
+}
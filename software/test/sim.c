@@ -0,0 +1,211 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * sim.c: Virtual clock, inputs and SPITFP of the host simulation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "sim.h"
+
+#include <string.h>
+
+#include "bricklib2/protocols/tfp/tfp.h"
+#include "bricklib2/utility/util_definitions.h"
+#include "configs/config_ac_in.h"
+#include "communication.h"
+#include "loop_timing.h"
+#include "low_power.h"
+#include "outage_log.h"
+#include "scheduler.h"
+#include "time_sync.h"
+#include "timestamp.h"
+#include "waveform.h"
+
+Sim sim;
+
+void IRQ_Hdlr_3(void);
+void IRQ_Hdlr_4(void);
+
+static void (*const sim_edge_irq[AC_IN_CHANNEL_NUM])(void) = {
+    IRQ_Hdlr_3,
+    IRQ_Hdlr_4
+};
+
+static void sim_start(const uint64_t start_us, const bool keep_eeprom) {
+    void (*message_handler)(const uint64_t, const uint8_t*, const uint8_t) = sim.message_handler;
+    static uint8_t eeprom[BOOTLOADER_FLASH_EEPROM_SIZE];
+    if(keep_eeprom) {
+        memcpy(eeprom, sim.eeprom, sizeof(eeprom));
+    }
+
+    memset(&sim, 0, sizeof(Sim));
+    if(keep_eeprom) {
+        memcpy(sim.eeprom, eeprom, sizeof(eeprom));
+    }
+    memset(sim_port, 0, sizeof(sim_port));
+    sim.time_us         = start_us;
+    sim.next_loop       = start_us;
+    sim.loop_interval   = SIM_LOOP_INTERVAL_DEFAULT;
+    sim.send_possible   = true;
+    sim.message_handler = message_handler;
+
+    // Inputs are pulled up, without voltage the opto does not conduct
+    for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+        AC_IN_INPUT_PORT->IN |= 1 << (AC_IN_INPUT_SHIFT + ch);
+    }
+
+    // Same order as in main()
+    communication_init();
+    timestamp_init();
+    outage_log_init();
+    low_power_init();
+    time_sync_init();
+    ac_in_init();
+    waveform_init();
+    scheduler_init();
+    loop_timing_reset();
+}
+
+void sim_init(const uint64_t start_us) {
+    sim_start(start_us, false);
+}
+
+void sim_reset(void) {
+    sim_start(sim.time_us, true);
+}
+
+bool sim_get_input(const uint8_t channel) {
+    return (AC_IN_INPUT_PORT->IN >> (AC_IN_INPUT_SHIFT + channel)) & 1;
+}
+
+void sim_set_input(const uint8_t channel, const bool level) {
+    if(sim_get_input(channel) == level) {
+        return;
+    }
+
+    AC_IN_INPUT_PORT->IN ^= 1 << (AC_IN_INPUT_SHIFT + channel);
+    sim.last_edge[channel] = sim.time_us;
+    sim_edge_irq[channel]();
+
+    // The edge interrupt wakes up the main loop
+    if(sim.sleeping) {
+        sim.sleeping  = false;
+        sim.next_loop = sim.time_us;
+    }
+}
+
+void sim_set_ac(const uint8_t channel, const uint32_t period, const uint32_t on_time) {
+    sim.signal[channel].ac        = true;
+    sim.signal[channel].period    = period;
+    sim.signal[channel].on_time   = on_time;
+    sim.signal[channel].next_edge = sim.time_us;
+}
+
+void sim_set_level(const uint8_t channel, const bool level) {
+    sim.signal[channel].ac = false;
+    sim_set_input(channel, level);
+}
+
+static void sim_signal_edge(const uint8_t channel) {
+    SimSignal *signal = &sim.signal[channel];
+    const bool level  = !sim_get_input(channel);
+
+    sim_set_input(channel, level);
+    signal->next_edge += level ? (signal->period - signal->on_time) : signal->on_time;
+}
+
+static void sim_loop(void) {
+    scheduler_tick();
+    low_power_sleep();
+
+    if(sim.sleeping) {
+        sim.next_loop = (sim.time_us/1000 + 1)*1000; // Next SysTick
+    } else {
+        sim.next_loop = sim.time_us + sim.loop_interval;
+    }
+}
+
+// Edges that happen at the same time as a main loop iteration come first
+void sim_run_to(const uint64_t time_us) {
+    while(true) {
+        uint64_t next = sim.next_loop;
+        int8_t channel = -1;
+        for(uint8_t ch = 0; ch < AC_IN_CHANNEL_NUM; ch++) {
+            if(sim.signal[ch].ac && (sim.signal[ch].next_edge <= next)) {
+                next    = sim.signal[ch].next_edge;
+                channel = ch;
+            }
+        }
+
+        if(next > time_us) {
+            break;
+        }
+
+        sim.time_us = next;
+        if(channel >= 0) {
+            sim_signal_edge(channel);
+        } else {
+            sim_loop();
+        }
+    }
+
+    sim.time_us = time_us;
+}
+
+void sim_run(const uint64_t duration_us) {
+    sim_run_to(sim.time_us + duration_us);
+}
+
+BootloaderHandleMessageResponse sim_request(void *message, const uint8_t length, const uint8_t fid, void *response) {
+    static uint8_t response_buffer[SIM_MESSAGE_SIZE];
+
+    tfp_make_default_header(message, bootloader_get_uid(), length, fid);
+    if(response == NULL) {
+        response = response_buffer;
+    }
+
+    return handle_message(message, response);
+}
+
+uint32_t sim_get_message_count(const uint8_t fid) {
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < MIN(sim.message_count, SIM_MESSAGE_NUM); i++) {
+        if(tfp_get_fid_from_message(sim.message[i].data) == fid) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+const SimMessage *sim_get_message(const uint8_t fid, const uint32_t index) {
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < MIN(sim.message_count, SIM_MESSAGE_NUM); i++) {
+        if(tfp_get_fid_from_message(sim.message[i].data) == fid) {
+            if(count == index) {
+                return &sim.message[i];
+            }
+            count++;
+        }
+    }
+
+    return NULL;
+}
+
+void sim_clear_messages(void) {
+    sim.message_count = 0;
+}
@@ -0,0 +1,98 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * sim.h: Virtual clock, inputs and SPITFP of the host simulation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bricklib2/bootloader/bootloader.h"
+#include "ac_in.h"
+
+// Time between two main loop iterations in us. In low power mode the loop
+// sleeps until the next SysTick (1 ms) or the next input edge instead.
+#define SIM_LOOP_INTERVAL_DEFAULT 20
+
+#define SIM_MESSAGE_NUM  256
+#define SIM_MESSAGE_SIZE 80
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t  length;
+    uint8_t  data[SIM_MESSAGE_SIZE];
+} SimMessage;
+
+// Scripted input of one channel: Square wave while ac is set, constant level otherwise.
+// The on-time is the time with low input (the opto conducts).
+typedef struct {
+    bool     ac;
+    uint32_t period;  // in us
+    uint32_t on_time; // in us
+    uint64_t next_edge;
+} SimSignal;
+
+typedef struct {
+    uint64_t time_us; // Virtual clock, the firmware sees it modulo 2^32 us / 2^32 ms
+    uint64_t next_loop;
+    uint32_t loop_interval;
+    bool     sleeping;
+
+    SimSignal signal[AC_IN_CHANNEL_NUM];
+    uint64_t  last_edge[AC_IN_CHANNEL_NUM]; // in us
+
+    bool     send_possible;
+    uint32_t message_count; // All sent messages, only the first SIM_MESSAGE_NUM are kept
+    SimMessage message[SIM_MESSAGE_NUM];
+    void (*message_handler)(const uint64_t time_us, const uint8_t *data, const uint8_t length); // Optional
+
+    uint8_t  eeprom[BOOTLOADER_FLASH_EEPROM_SIZE];
+    uint32_t eeprom_write_count;
+} Sim;
+
+extern Sim sim;
+
+// Resets the virtual hardware and initializes all firmware modules like main()
+void sim_init(const uint64_t start_us);
+
+// Restarts the firmware at the current time, the EEPROM keeps its content
+void sim_reset(void);
+
+// Runs the main loop and the scripted inputs up to the given time
+void sim_run_to(const uint64_t time_us);
+void sim_run(const uint64_t duration_us);
+
+// Changes an input right now, the edge interrupt is called if the level changes
+void sim_set_input(const uint8_t channel, const bool level);
+bool sim_get_input(const uint8_t channel);
+
+// The first edge of the square wave is right now
+void sim_set_ac(const uint8_t channel, const uint32_t period, const uint32_t on_time);
+void sim_set_level(const uint8_t channel, const bool level);
+
+// Sends a request to the message handler, the header is filled in here
+BootloaderHandleMessageResponse sim_request(void *message, const uint8_t length, const uint8_t fid, void *response);
+
+uint32_t sim_get_message_count(const uint8_t fid);
+const SimMessage *sim_get_message(const uint8_t fid, const uint32_t index);
+void sim_clear_messages(void);
+
+#endif
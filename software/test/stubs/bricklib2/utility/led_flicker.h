@@ -0,0 +1,37 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * led_flicker.h: Host stub of the bricklib2 LED flicker
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef LED_FLICKER_H
+#define LED_FLICKER_H
+
+#include <stdint.h>
+
+#include "xmc_gpio.h"
+
+typedef struct {
+    uint32_t config;
+    uint32_t counter;
+    uint32_t start;
+} LEDFlickerState;
+
+void led_flicker_tick(LEDFlickerState *led_flicker_state, const uint32_t current_time, XMC_GPIO_PORT_t *const port, const uint8_t pin);
+
+#endif
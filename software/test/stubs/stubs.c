@@ -0,0 +1,328 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * stubs.c: Host implementation of the bricklib2 and XMCLib functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "sim.h"
+
+#include <string.h>
+
+#include "bricklib2/hal/system_timer/system_timer.h"
+#include "bricklib2/protocols/tfp/tfp.h"
+#include "bricklib2/utility/communication_callback.h"
+#include "bricklib2/utility/led_flicker.h"
+#include "bricklib2/utility/pearson_hash.h"
+#include "bricklib2/utility/util_definitions.h"
+#include "xmc_ccu4.h"
+#include "xmc_eru.h"
+#include "xmc_gpio.h"
+#include "communication.h"
+
+#define SIM_UID 0x12345678
+
+XMC_GPIO_PORT_t sim_port[3];
+XMC_ERU_t sim_eru;
+XMC_CCU4_MODULE_t sim_ccu40;
+XMC_CCU4_SLICE_t sim_ccu40_slice[4];
+BootloaderStatus bootloader_status;
+uint32_t SystemCoreClock = 32000000;
+
+static SysTick_Type sim_systick;
+
+// Any permutation works on the host, the checksum only has to be consistent
+const uint8_t pearson_permutation[256] = {
+     13, 180,  91,   2, 169,  80, 247, 158,  69, 236, 147,  58, 225, 136,  47, 214,
+    125,  36, 203, 114,  25, 192, 103,  14, 181,  92,   3, 170,  81, 248, 159,  70,
+    237, 148,  59, 226, 137,  48, 215, 126,  37, 204, 115,  26, 193, 104,  15, 182,
+     93,   4, 171,  82, 249, 160,  71, 238, 149,  60, 227, 138,  49, 216, 127,  38,
+    205, 116,  27, 194, 105,  16, 183,  94,   5, 172,  83, 250, 161,  72, 239, 150,
+     61, 228, 139,  50, 217, 128,  39, 206, 117,  28, 195, 106,  17, 184,  95,   6,
+    173,  84, 251, 162,  73, 240, 151,  62, 229, 140,  51, 218, 129,  40, 207, 118,
+     29, 196, 107,  18, 185,  96,   7, 174,  85, 252, 163,  74, 241, 152,  63, 230,
+    141,  52, 219, 130,  41, 208, 119,  30, 197, 108,  19, 186,  97,   8, 175,  86,
+    253, 164,  75, 242, 153,  64, 231, 142,  53, 220, 131,  42, 209, 120,  31, 198,
+    109,  20, 187,  98,   9, 176,  87, 254, 165,  76, 243, 154,  65, 232, 143,  54,
+    221, 132,  43, 210, 121,  32, 199, 110,  21, 188,  99,  10, 177,  88, 255, 166,
+     77, 244, 155,  66, 233, 144,  55, 222, 133,  44, 211, 122,  33, 200, 111,  22,
+    189, 100,  11, 178,  89,   0, 167,  78, 245, 156,  67, 234, 145,  56, 223, 134,
+     45, 212, 123,  34, 201, 112,  23, 190, 101,  12, 179,  90,   1, 168,  79, 246,
+    157,  68, 235, 146,  57, 224, 135,  46, 213, 124,  35, 202, 113,  24, 191, 102,
+};
+
+// --- CMSIS ---
+
+SysTick_Type *sim_get_systick(void) {
+    // SysTick counts down from LOAD to 0 once per ms
+    const uint32_t cycles_per_us = SystemCoreClock/1000000;
+    sim_systick.LOAD = SystemCoreClock/1000 - 1;
+    sim_systick.VAL  = sim_systick.LOAD - (sim.time_us % 1000)*cycles_per_us;
+
+    return &sim_systick;
+}
+
+void NVIC_EnableIRQ(int irq) {
+    (void)irq;
+}
+
+void NVIC_DisableIRQ(int irq) {
+    (void)irq;
+}
+
+void NVIC_ClearPendingIRQ(int irq) {
+    (void)irq;
+}
+
+void NVIC_SetPriority(int irq, int priority) {
+    (void)irq;
+    (void)priority;
+}
+
+void __disable_irq(void) {}
+void __enable_irq(void) {}
+void __DSB(void) {}
+
+// The main loop sleeps until the next SysTick or input edge
+void __WFI(void) {
+    sim.sleeping = true;
+}
+
+// --- XMCLib ---
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *port, uint8_t pin, const XMC_GPIO_CONFIG_t *config) {
+    if(config->mode == XMC_GPIO_MODE_INPUT_TRISTATE) {
+        return;
+    }
+
+    if(config->output_level == XMC_GPIO_OUTPUT_LEVEL_HIGH) {
+        XMC_GPIO_SetOutputHigh(port, pin);
+    } else {
+        XMC_GPIO_SetOutputLow(port, pin);
+    }
+}
+
+uint32_t XMC_GPIO_GetInput(XMC_GPIO_PORT_t *port, uint8_t pin) {
+    return (port->IN >> pin) & 1;
+}
+
+void XMC_GPIO_SetOutputLow(XMC_GPIO_PORT_t *port, uint8_t pin) {
+    port->OUT &= ~(1 << pin);
+}
+
+void XMC_GPIO_SetOutputHigh(XMC_GPIO_PORT_t *port, uint8_t pin) {
+    port->OUT |= 1 << pin;
+}
+
+void XMC_GPIO_ToggleOutput(XMC_GPIO_PORT_t *port, uint8_t pin) {
+    port->OUT ^= 1 << pin;
+}
+
+void XMC_ERU_ETL_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_ETL_CONFIG_t *const config) {
+    (void)eru;
+    (void)channel;
+    (void)config;
+}
+
+void XMC_ERU_OGU_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_OGU_CONFIG_t *const config) {
+    (void)eru;
+    (void)channel;
+    (void)config;
+}
+
+void XMC_CCU4_Init(XMC_CCU4_MODULE_t *const module, const XMC_CCU4_SLICE_MCMS_ACTION_t mcs_action) {
+    (void)module;
+    (void)mcs_action;
+}
+
+void XMC_CCU4_StartPrescaler(XMC_CCU4_MODULE_t *const module) {
+    (void)module;
+}
+
+void XMC_CCU4_EnableClock(XMC_CCU4_MODULE_t *const module, const uint8_t slice_number) {
+    (void)module;
+    (void)slice_number;
+}
+
+void XMC_CCU4_EnableShadowTransfer(XMC_CCU4_MODULE_t *const module, const uint32_t shadow_transfer_msk) {
+    (void)module;
+    (void)shadow_transfer_msk;
+}
+
+void XMC_CCU4_SLICE_CompareInit(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_COMPARE_CONFIG_t *const compare_init) {
+    (void)slice;
+    (void)compare_init;
+}
+
+void XMC_CCU4_SLICE_SetTimerPeriodMatch(XMC_CCU4_SLICE_t *const slice, const uint16_t period_val) {
+    (void)slice;
+    (void)period_val;
+}
+
+void XMC_CCU4_SLICE_SetTimerCompareMatch(XMC_CCU4_SLICE_t *const slice, const uint16_t compare_val) {
+    (void)slice;
+    (void)compare_val;
+}
+
+void XMC_CCU4_SLICE_StartTimer(XMC_CCU4_SLICE_t *const slice) {
+    slice->running = true;
+}
+
+void XMC_CCU4_SLICE_StopTimer(XMC_CCU4_SLICE_t *const slice) {
+    slice->running = false;
+}
+
+void XMC_CCU4_SLICE_ClearTimer(XMC_CCU4_SLICE_t *const slice) {
+    (void)slice;
+}
+
+// The concatenated slices 0 (low) and 1 (high) are the us timestamp
+uint16_t XMC_CCU4_SLICE_GetTimerValue(const XMC_CCU4_SLICE_t *const slice) {
+    const uint32_t time_us = (uint32_t)sim.time_us;
+    if(slice == CCU40_CC40) {
+        return time_us & 0xFFFF;
+    } else if(slice == CCU40_CC41) {
+        return time_us >> 16;
+    }
+
+    return 0;
+}
+
+void XMC_CCU4_SLICE_EnableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+    (void)slice;
+    (void)event;
+}
+
+void XMC_CCU4_SLICE_DisableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+    (void)slice;
+    (void)event;
+}
+
+void XMC_CCU4_SLICE_ClearEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event) {
+    (void)slice;
+    (void)event;
+}
+
+void XMC_CCU4_SLICE_SetInterruptNode(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event, const XMC_CCU4_SLICE_SR_ID_t sr) {
+    (void)slice;
+    (void)event;
+    (void)sr;
+}
+
+// --- bricklib2 ---
+
+uint32_t system_timer_get_ms(void) {
+    return (uint32_t)(sim.time_us/1000);
+}
+
+bool system_timer_is_time_elapsed_ms(const uint32_t start_measurement, const uint32_t time_to_be_elapsed) {
+    return (uint32_t)(system_timer_get_ms() - start_measurement) >= time_to_be_elapsed;
+}
+
+uint32_t bootloader_get_uid(void) {
+    return SIM_UID;
+}
+
+bool bootloader_spitfp_is_send_possible(SPITFP *st) {
+    (void)st;
+    return sim.send_possible;
+}
+
+void bootloader_spitfp_send_ack_and_message(BootloaderStatus *bs, uint8_t *data, const uint8_t length) {
+    (void)bs;
+
+    if(sim.message_count < SIM_MESSAGE_NUM) {
+        SimMessage *message = &sim.message[sim.message_count];
+        message->time_us = sim.time_us;
+        message->length  = MIN(length, SIM_MESSAGE_SIZE);
+        memcpy(message->data, data, message->length);
+    }
+    sim.message_count++;
+
+    if(sim.message_handler != NULL) {
+        sim.message_handler(sim.time_us, data, length);
+    }
+}
+
+// Requests are sent directly with sim_request, there is no SPITFP stack
+void bootloader_tick(void) {}
+
+bool bootloader_read_eeprom_page(const uint32_t page_num, uint32_t *data) {
+    if(page_num >= BOOTLOADER_FLASH_EEPROM_SIZE/EEPROM_PAGE_SIZE) {
+        return false;
+    }
+
+    memcpy(data, &sim.eeprom[page_num*EEPROM_PAGE_SIZE], EEPROM_PAGE_SIZE);
+    return true;
+}
+
+bool bootloader_write_eeprom_page(const uint32_t page_num, uint32_t *data) {
+    if(page_num >= BOOTLOADER_FLASH_EEPROM_SIZE/EEPROM_PAGE_SIZE) {
+        return false;
+    }
+
+    memcpy(&sim.eeprom[page_num*EEPROM_PAGE_SIZE], data, EEPROM_PAGE_SIZE);
+    sim.eeprom_write_count++;
+    return true;
+}
+
+uint8_t tfp_get_fid_from_message(const void *message) {
+    return ((const TFPMessageHeader*)message)->fid;
+}
+
+uint8_t tfp_get_length_from_message(const void *message) {
+    return ((const TFPMessageHeader*)message)->length;
+}
+
+void tfp_make_default_header(TFPMessageHeader *header, const uint32_t uid, const uint8_t length, const uint8_t fid) {
+    memset(header, 0, sizeof(TFPMessageHeader));
+    header->uid    = uid;
+    header->length = length;
+    header->fid    = fid;
+}
+
+// Same dispatching as in bricklib2: At most one callback per tick, round robin over all handlers
+static const handler_function_t communication_callbacks[] = {COMMUNICATION_CALLBACK_LIST_INIT};
+static uint32_t communication_callback_last_tick;
+static uint8_t communication_callback_index;
+
+void communication_callback_tick(void) {
+    if(!system_timer_is_time_elapsed_ms(communication_callback_last_tick, COMMUNICATION_CALLBACK_TICK_WAIT_MS)) {
+        return;
+    }
+    communication_callback_last_tick = system_timer_get_ms();
+
+    for(uint8_t i = 0; i < COMMUNICATION_CALLBACK_HANDLER_NUM; i++) {
+        const bool sent = communication_callbacks[communication_callback_index]();
+        communication_callback_index = (communication_callback_index + 1) % COMMUNICATION_CALLBACK_HANDLER_NUM;
+        if(sent) {
+            return;
+        }
+    }
+}
+
+void communication_callback_init(void) {
+    communication_callback_last_tick = system_timer_get_ms();
+    communication_callback_index     = 0;
+}
+
+// The heartbeat is not simulated, the LED is only switched on
+void led_flicker_tick(LEDFlickerState *led_flicker_state, const uint32_t current_time, XMC_GPIO_PORT_t *const port, const uint8_t pin) {
+    (void)led_flicker_state;
+    (void)current_time;
+    XMC_GPIO_SetOutputLow(port, pin);
+}
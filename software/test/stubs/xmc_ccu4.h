@@ -0,0 +1,99 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * xmc_ccu4.h: Host stub of the XMCLib CCU4 driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_CCU4_H
+#define XMC_CCU4_H
+
+#include "xmc_device.h"
+
+// Slice 0 and 1 of CCU40 return the low and high half of the virtual us clock,
+// all other slices only count the configuration calls
+
+typedef struct {
+    uint32_t unused;
+} XMC_CCU4_MODULE_t;
+
+typedef struct {
+    uint32_t running;
+} XMC_CCU4_SLICE_t;
+
+extern XMC_CCU4_MODULE_t sim_ccu40;
+extern XMC_CCU4_SLICE_t sim_ccu40_slice[4];
+#define CCU40      (&sim_ccu40)
+#define CCU40_CC40 (&sim_ccu40_slice[0])
+#define CCU40_CC41 (&sim_ccu40_slice[1])
+#define CCU40_CC42 (&sim_ccu40_slice[2])
+#define CCU40_CC43 (&sim_ccu40_slice[3])
+
+typedef enum {
+    XMC_CCU4_SLICE_PRESCALER_1,
+    XMC_CCU4_SLICE_PRESCALER_2,
+    XMC_CCU4_SLICE_PRESCALER_4,
+    XMC_CCU4_SLICE_PRESCALER_8,
+    XMC_CCU4_SLICE_PRESCALER_16,
+    XMC_CCU4_SLICE_PRESCALER_32,
+    XMC_CCU4_SLICE_PRESCALER_64
+} XMC_CCU4_SLICE_PRESCALER_t;
+
+typedef enum { XMC_CCU4_SLICE_TIMER_COUNT_MODE_EA } XMC_CCU4_SLICE_TIMER_COUNT_MODE_t;
+typedef enum { XMC_CCU4_SLICE_TIMER_REPEAT_MODE_REPEAT, XMC_CCU4_SLICE_TIMER_REPEAT_MODE_SINGLE } XMC_CCU4_SLICE_TIMER_REPEAT_MODE_t;
+typedef enum { XMC_CCU4_SLICE_PRESCALER_MODE_NORMAL } XMC_CCU4_SLICE_PRESCALER_MODE_t;
+typedef enum { XMC_CCU4_SLICE_MCMS_ACTION_TRANSFER_PR_CR } XMC_CCU4_SLICE_MCMS_ACTION_t;
+typedef enum { XMC_CCU4_SLICE_IRQ_ID_PERIOD_MATCH } XMC_CCU4_SLICE_IRQ_ID_t;
+typedef enum { XMC_CCU4_SLICE_SR_ID_0, XMC_CCU4_SLICE_SR_ID_1, XMC_CCU4_SLICE_SR_ID_2, XMC_CCU4_SLICE_SR_ID_3 } XMC_CCU4_SLICE_SR_ID_t;
+
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_0 (1 << 0)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_1 (1 << 4)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_2 (1 << 8)
+#define XMC_CCU4_SHADOW_TRANSFER_SLICE_3 (1 << 12)
+
+typedef struct {
+    uint32_t timer_mode;
+    uint32_t monoshot;
+    uint32_t shadow_xfer_clear;
+    uint32_t dither_timer_period;
+    uint32_t dither_duty_cycle;
+    uint32_t prescaler_mode;
+    uint32_t mcm_enable;
+    uint32_t prescaler_initval;
+    uint32_t float_limit;
+    uint32_t dither_limit;
+    uint32_t passive_level;
+    uint32_t timer_concatenation;
+} XMC_CCU4_SLICE_COMPARE_CONFIG_t;
+
+void XMC_CCU4_Init(XMC_CCU4_MODULE_t *const module, const XMC_CCU4_SLICE_MCMS_ACTION_t mcs_action);
+void XMC_CCU4_StartPrescaler(XMC_CCU4_MODULE_t *const module);
+void XMC_CCU4_EnableClock(XMC_CCU4_MODULE_t *const module, const uint8_t slice_number);
+void XMC_CCU4_EnableShadowTransfer(XMC_CCU4_MODULE_t *const module, const uint32_t shadow_transfer_msk);
+void XMC_CCU4_SLICE_CompareInit(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_COMPARE_CONFIG_t *const compare_init);
+void XMC_CCU4_SLICE_SetTimerPeriodMatch(XMC_CCU4_SLICE_t *const slice, const uint16_t period_val);
+void XMC_CCU4_SLICE_SetTimerCompareMatch(XMC_CCU4_SLICE_t *const slice, const uint16_t compare_val);
+void XMC_CCU4_SLICE_StartTimer(XMC_CCU4_SLICE_t *const slice);
+void XMC_CCU4_SLICE_StopTimer(XMC_CCU4_SLICE_t *const slice);
+void XMC_CCU4_SLICE_ClearTimer(XMC_CCU4_SLICE_t *const slice);
+uint16_t XMC_CCU4_SLICE_GetTimerValue(const XMC_CCU4_SLICE_t *const slice);
+void XMC_CCU4_SLICE_EnableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event);
+void XMC_CCU4_SLICE_DisableEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event);
+void XMC_CCU4_SLICE_ClearEvent(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event);
+void XMC_CCU4_SLICE_SetInterruptNode(XMC_CCU4_SLICE_t *const slice, const XMC_CCU4_SLICE_IRQ_ID_t event, const XMC_CCU4_SLICE_SR_ID_t sr);
+
+#endif
@@ -0,0 +1,64 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * xmc_device.h: Host stub of the XMC1100 device header
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_DEVICE_H
+#define XMC_DEVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Peripheral registers are plain variables of the simulation (see sim.h)
+
+typedef struct {
+    volatile uint32_t IN;
+    volatile uint32_t OUT;
+    volatile uint32_t OMR;
+} XMC_GPIO_PORT_t;
+
+extern XMC_GPIO_PORT_t sim_port[3];
+#define PORT0 (&sim_port[0])
+#define PORT1 (&sim_port[1])
+#define PORT2 (&sim_port[2])
+
+typedef struct {
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+} SysTick_Type;
+
+// The down-counter is updated from the virtual clock on every access
+SysTick_Type *sim_get_systick(void);
+#define SysTick (sim_get_systick())
+
+extern uint32_t SystemCoreClock;
+
+void NVIC_EnableIRQ(int irq);
+void NVIC_DisableIRQ(int irq);
+void NVIC_ClearPendingIRQ(int irq);
+void NVIC_SetPriority(int irq, int priority);
+
+// Interrupts are called synchronously by the simulation, there is nothing to mask
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+void __DSB(void);
+
+#endif
@@ -0,0 +1,64 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * xmc_eru.h: Host stub of the XMCLib ERU driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_ERU_H
+#define XMC_ERU_H
+
+#include "xmc_device.h"
+
+// The edge interrupts are called directly by the simulation when an input changes,
+// the event trigger logic configuration is not evaluated
+
+typedef struct {
+    uint32_t unused;
+} XMC_ERU_t;
+
+extern XMC_ERU_t sim_eru;
+#define XMC_ERU0 (&sim_eru)
+
+enum { XMC_ERU_ETL_INPUT_A0, XMC_ERU_ETL_INPUT_A1, XMC_ERU_ETL_INPUT_A2, XMC_ERU_ETL_INPUT_A3 };
+enum { XMC_ERU_ETL_INPUT_B0, XMC_ERU_ETL_INPUT_B1, XMC_ERU_ETL_INPUT_B2, XMC_ERU_ETL_INPUT_B3 };
+enum { XMC_ERU_ETL_SOURCE_A, XMC_ERU_ETL_SOURCE_B };
+enum { XMC_ERU_ETL_EDGE_DETECTION_DISABLED, XMC_ERU_ETL_EDGE_DETECTION_RISING, XMC_ERU_ETL_EDGE_DETECTION_FALLING, XMC_ERU_ETL_EDGE_DETECTION_BOTH };
+enum { XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL0, XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL1, XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL2, XMC_ERU_ETL_OUTPUT_TRIGGER_CHANNEL3 };
+enum { XMC_ERU_OGU_SERVICE_REQUEST_DISABLED, XMC_ERU_OGU_SERVICE_REQUEST_ON_TRIGGER };
+
+typedef struct {
+    uint32_t input_a;
+    uint32_t input_b;
+    uint32_t enable_output_trigger;
+    uint32_t status_flag_mode;
+    uint32_t edge_detection;
+    uint32_t output_trigger_channel;
+    uint32_t source;
+} XMC_ERU_ETL_CONFIG_t;
+
+typedef struct {
+    uint32_t peripheral_trigger;
+    uint32_t enable_pattern_detection;
+    uint32_t service_request;
+    uint32_t pattern_detection_input;
+} XMC_ERU_OGU_CONFIG_t;
+
+void XMC_ERU_ETL_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_ETL_CONFIG_t *const config);
+void XMC_ERU_OGU_Init(XMC_ERU_t *const eru, const uint8_t channel, const XMC_ERU_OGU_CONFIG_t *const config);
+
+#endif
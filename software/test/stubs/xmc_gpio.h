@@ -0,0 +1,69 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * xmc_gpio.h: Host stub of the XMCLib GPIO driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef XMC_GPIO_H
+#define XMC_GPIO_H
+
+#include "xmc_device.h"
+
+#define P0_7  PORT0, 7
+#define P0_8  PORT0, 8
+#define P0_9  PORT0, 9
+#define P0_12 PORT0, 12
+#define P0_13 PORT0, 13
+#define P0_14 PORT0, 14
+#define P0_15 PORT0, 15
+#define P2_0  PORT2, 0
+#define P2_1  PORT2, 1
+#define P2_2  PORT2, 2
+#define P2_10 PORT2, 10
+
+#define P2_0_AF_U0C0_DOUT0  6
+#define P0_15_AF_U0C0_DOUT0 6
+
+typedef enum {
+    XMC_GPIO_MODE_INPUT_TRISTATE,
+    XMC_GPIO_MODE_OUTPUT_PUSH_PULL,
+    XMC_GPIO_MODE_OUTPUT_PUSH_PULL_ALT6
+} XMC_GPIO_MODE_t;
+
+typedef enum {
+    XMC_GPIO_INPUT_HYSTERESIS_STANDARD
+} XMC_GPIO_INPUT_HYSTERESIS_t;
+
+typedef enum {
+    XMC_GPIO_OUTPUT_LEVEL_LOW,
+    XMC_GPIO_OUTPUT_LEVEL_HIGH
+} XMC_GPIO_OUTPUT_LEVEL_t;
+
+typedef struct {
+    XMC_GPIO_MODE_t mode;
+    XMC_GPIO_OUTPUT_LEVEL_t output_level;
+    XMC_GPIO_INPUT_HYSTERESIS_t input_hysteresis;
+} XMC_GPIO_CONFIG_t;
+
+void XMC_GPIO_Init(XMC_GPIO_PORT_t *port, uint8_t pin, const XMC_GPIO_CONFIG_t *config);
+uint32_t XMC_GPIO_GetInput(XMC_GPIO_PORT_t *port, uint8_t pin);
+void XMC_GPIO_SetOutputLow(XMC_GPIO_PORT_t *port, uint8_t pin);
+void XMC_GPIO_SetOutputHigh(XMC_GPIO_PORT_t *port, uint8_t pin);
+void XMC_GPIO_ToggleOutput(XMC_GPIO_PORT_t *port, uint8_t pin);
+
+#endif
@@ -0,0 +1,94 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * test.h: Minimal test runner for the host tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// A failed check ends the test function, the other tests still run
+extern bool test_failed;
+
+#define TEST_ASSERT(condition) do { \
+    if(!(condition)) { \
+        printf("    %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+        test_failed = true; \
+        return; \
+    } \
+} while(0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) do { \
+    const long long test_expected = (long long)(expected); \
+    const long long test_actual   = (long long)(actual); \
+    if(test_expected != test_actual) { \
+        printf("    %s:%d: %s == %s (expected %lld, got %lld)\n", __FILE__, __LINE__, #expected, #actual, test_expected, test_actual); \
+        test_failed = true; \
+        return; \
+    } \
+} while(0)
+
+#define TEST_ASSERT_BETWEEN(min, actual, max) do { \
+    const long long test_min    = (long long)(min); \
+    const long long test_actual = (long long)(actual); \
+    const long long test_max    = (long long)(max); \
+    if((test_actual < test_min) || (test_actual > test_max)) { \
+        printf("    %s:%d: %s in [%s, %s] (got %lld, expected %lld to %lld)\n", __FILE__, __LINE__, #actual, #min, #max, test_actual, test_min, test_max); \
+        test_failed = true; \
+        return; \
+    } \
+} while(0)
+
+typedef struct {
+    const char *name;
+    void (*function)(void);
+} Test;
+
+#define TEST(function) {#function, function}
+
+// Runs all tests, or only the tests given on the command line. Returns the exit code.
+static inline int test_run(const Test *tests, const size_t count, const int argc, char **argv) {
+    uint32_t failed = 0;
+    uint32_t run    = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        bool selected = argc < 2;
+        for(int arg = 1; arg < argc; arg++) {
+            selected |= strcmp(argv[arg], tests[i].name) == 0;
+        }
+        if(!selected) {
+            continue;
+        }
+
+        test_failed = false;
+        tests[i].function();
+        printf("%s %s\n", test_failed ? "FAIL" : "ok  ", tests[i].name);
+        failed += test_failed ? 1 : 0;
+        run++;
+    }
+
+    printf("%u tests, %u failed\n", run, failed);
+    return ((failed == 0) && (run != 0)) ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,315 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * test_ac_in.c: Tests for the AC detection, the glitch filter and the measurements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "test.h"
+#include "sim.h"
+
+#include "communication.h"
+#include "scheduler.h"
+
+#define PERIOD_50HZ   20000
+#define PERIOD_60HZ   16667
+#define PERIOD_16_7HZ 59880
+
+bool test_failed;
+
+// Like on the hardware the value starts with the input level. Without AC the
+// input is high, so both channels are only reported as absent after the timeout.
+static void start(void) {
+    sim_init(0);
+    sim_run(200000);
+}
+
+static void set_detection(const uint8_t channel, const uint8_t mode, const uint16_t timeout, const uint8_t missed_edges) {
+    SetDetectionConfiguration request = {.channel = channel, .mode = mode, .timeout = timeout, .missed_edges = missed_edges};
+    sim_request(&request, sizeof(request), FID_SET_DETECTION_CONFIGURATION, NULL);
+}
+
+static void set_filter(const uint8_t channel, const uint16_t min_pulse_width, const uint8_t min_edges) {
+    SetFilterConfiguration request = {.channel = channel, .min_pulse_width = min_pulse_width, .min_edges = min_edges};
+    sim_request(&request, sizeof(request), FID_SET_FILTER_CONFIGURATION, NULL);
+}
+
+static bool is_present(const uint8_t channel) {
+    return (ac_in.value & (1 << channel)) != 0;
+}
+
+// Stops the square wave without another edge and returns the time in us
+// from the last edge until the channel is reported as lost
+static uint64_t run_until_lost(const uint8_t channel, const uint64_t max_duration) {
+    sim.signal[channel].ac = false;
+    while(is_present(channel) && (sim.time_us - sim.last_edge[channel] < max_duration)) {
+        sim_run(10);
+    }
+
+    return sim.time_us - sim.last_edge[channel];
+}
+
+static void test_presence_after_first_edge(void) {
+    start();
+    sim_run(200000);
+    TEST_ASSERT(!is_present(0));
+    TEST_ASSERT(!is_present(1));
+
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(100);
+    TEST_ASSERT(is_present(0));
+    TEST_ASSERT(!is_present(1));
+}
+
+static void test_loss_fixed_timeout(void) {
+    start();
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(500000);
+    TEST_ASSERT(is_present(0));
+
+    // The default timeout is 100 ms, the ms system timer adds up to 1 ms of jitter
+    TEST_ASSERT_BETWEEN(99000, run_until_lost(0, 1000000), 101000);
+    TEST_ASSERT_EQUAL(0, ac_in_get_frequency(0));
+}
+
+static void test_loss_adaptive_timeout(void) {
+    // Timeout of the adaptive mode is (missed edges + 1) half periods
+    const struct {
+        uint32_t period;
+        uint8_t missed_edges;
+        uint32_t timeout;
+    } cases[] = {
+        {PERIOD_50HZ,   2, 30000},
+        {PERIOD_60HZ,   2, 25000},
+        {PERIOD_16_7HZ, 2, 89820},
+        {PERIOD_50HZ,   5, 60000},
+    };
+
+    for(size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+        start();
+        set_detection(0, INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE, 100, cases[i].missed_edges);
+        sim_set_ac(0, cases[i].period, cases[i].period/2);
+        sim_run(1000000);
+        TEST_ASSERT(is_present(0));
+
+        TEST_ASSERT_BETWEEN(cases[i].timeout - 1000, run_until_lost(0, 1000000), cases[i].timeout + 1000);
+    }
+}
+
+static void test_no_loss_with_steady_ac(void) {
+    const uint32_t periods[] = {PERIOD_50HZ, PERIOD_60HZ, PERIOD_16_7HZ};
+
+    for(size_t i = 0; i < sizeof(periods)/sizeof(periods[0]); i++) {
+        start();
+        set_detection(1, INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE, 100, 1);
+        sim_set_ac(0, periods[i], periods[i]/2);
+        sim_set_ac(1, periods[i], periods[i]/2);
+        sim_run(1000);
+
+        for(uint32_t ms = 0; ms < 5000; ms++) {
+            sim_run(1000);
+            TEST_ASSERT(is_present(0));
+            TEST_ASSERT(is_present(1));
+        }
+        TEST_ASSERT_EQUAL(0, ac_in.missed_half_wave_count[0]);
+        TEST_ASSERT_EQUAL(0, ac_in.missed_half_wave_count[1]);
+    }
+}
+
+static void test_loss_across_timestamp_wraparound(void) {
+    // The us timestamp wraps around after 2^32 us, the ms timer keeps counting
+    sim_init(0xFFFFFFFFULL - 300000);
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(600000);
+    TEST_ASSERT(is_present(0));
+    TEST_ASSERT_BETWEEN(49900, ac_in_get_frequency(0), 50100);
+
+    TEST_ASSERT_BETWEEN(99000, run_until_lost(0, 1000000), 101000);
+}
+
+static void test_edge_newer_than_tick_time(void) {
+    // An edge that was taken over from the interrupt after the scheduler read the
+    // time of the iteration is newer than now_ms and must not count as elapsed
+    start();
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(500000);
+    TEST_ASSERT(is_present(0));
+
+    ac_in.last_change[0] = scheduler_get_ms() + 1;
+    ac_in_tick();
+    TEST_ASSERT(is_present(0));
+}
+
+static void test_filter_min_edges(void) {
+    start();
+    set_filter(0, 0, 4);
+
+    // Edges at 0, 10, 20 and 30 ms
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(25000);
+    TEST_ASSERT(!is_present(0));
+    sim_run(6000);
+    TEST_ASSERT(is_present(0));
+}
+
+static void test_filter_min_edges_within_timeout(void) {
+    start();
+    set_filter(0, 0, 3);
+
+    // Each edge comes after the detection timeout of the edge before, the count starts over
+    for(uint8_t i = 0; i < 20; i++) {
+        sim_run(150000);
+        sim_set_input(0, !sim_get_input(0));
+        sim_run(100);
+        TEST_ASSERT(!is_present(0));
+    }
+
+    // Three edges within the timeout
+    for(uint8_t i = 0; i < 3; i++) {
+        sim_run(50000);
+        sim_set_input(0, !sim_get_input(0));
+    }
+    sim_run(100);
+    TEST_ASSERT(is_present(0));
+}
+
+static void test_filter_rejects_glitches(void) {
+    start();
+    set_filter(0, 1000, 1);
+
+    // 300 us pulses, both edges of each pulse are dropped
+    for(uint8_t i = 0; i < 50; i++) {
+        sim_run(20000);
+        sim_set_input(0, false);
+        sim_run(300);
+        sim_set_input(0, true);
+    }
+    sim_run(200000);
+    TEST_ASSERT(!is_present(0));
+    TEST_ASSERT_EQUAL(0, ac_in_get_edge_count(0, false));
+
+    // Without the filter the same pulses are seen as AC
+    set_filter(0, 0, 1);
+    sim_run(20000);
+    sim_set_input(0, false);
+    sim_run(300);
+    sim_set_input(0, true);
+    sim_run(100);
+    TEST_ASSERT(is_present(0));
+    TEST_ASSERT_EQUAL(2, ac_in_get_edge_count(0, false));
+}
+
+static void test_filter_keeps_edge_timing(void) {
+    start();
+    set_filter(0, 2000, 1);
+
+    // Accepted edges keep their original timestamp, the period is not affected by the delay
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(500000);
+    TEST_ASSERT(is_present(0));
+    TEST_ASSERT_BETWEEN(49900, ac_in_get_frequency(0), 50100);
+    TEST_ASSERT_EQUAL(PERIOD_50HZ, ac_in.period[0]);
+
+    // A loss is still detected, the pending last edge does not count twice
+    TEST_ASSERT_BETWEEN(99000, run_until_lost(0, 1000000), 101000);
+}
+
+static void test_filter_long_pulse_width(void) {
+    // Up to the maximum pulse width the accepted edges of a 50 Hz signal come later
+    // than a quarter of a half-wave after the last accepted edge
+    const uint16_t pulse_widths[] = {2600, 3000, AC_IN_FILTER_PULSE_WIDTH_MAX};
+
+    for(size_t i = 0; i < sizeof(pulse_widths)/sizeof(pulse_widths[0]); i++) {
+        start();
+        set_filter(0, pulse_widths[i], 1);
+        sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+        sim_run(2015000); // 5 ms after a rising edge (input high, opto off)
+        TEST_ASSERT(is_present(0));
+        TEST_ASSERT_BETWEEN(49900, ac_in_get_frequency(0), 50100);
+        TEST_ASSERT_EQUAL(0, ac_in.missed_half_wave_count[0]);
+
+        // A missing pulse is still counted as two missed half-waves
+        sim.signal[0].ac = false;
+        sim_run(25000);
+        sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+        sim_run(500000);
+        TEST_ASSERT(is_present(0));
+        TEST_ASSERT_EQUAL(2, ac_in.missed_half_wave_count[0]);
+    }
+}
+
+static void test_frequency_and_duty_cycle(void) {
+    const struct {
+        uint32_t period;
+        uint32_t on_time;
+        uint32_t frequency; // in mHz
+        uint16_t duty_cycle;
+    } cases[] = {
+        {PERIOD_50HZ,   10000, 50000, 5000},
+        {PERIOD_60HZ,   5000,  59999, 3000},
+        {PERIOD_16_7HZ, 41916, 16700, 7000},
+    };
+
+    for(size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+        start();
+        sim_set_ac(1, cases[i].period, cases[i].on_time);
+        sim_run(2000000);
+
+        TEST_ASSERT(is_present(1));
+        TEST_ASSERT_BETWEEN(cases[i].frequency - 10, ac_in_get_frequency(1), cases[i].frequency + 10);
+        TEST_ASSERT_BETWEEN(cases[i].duty_cycle - 5, ac_in.duty_cycle[1], cases[i].duty_cycle + 5);
+        TEST_ASSERT_EQUAL(INDUSTRIAL_DUAL_AC_IN_CHANNEL_STATE_AC, ac_in.state[1]);
+    }
+}
+
+static void test_missed_half_wave(void) {
+    start();
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(515000); // 5 ms after a rising edge (input high, opto off)
+    TEST_ASSERT(sim_get_input(0));
+    TEST_ASSERT_EQUAL(0, ac_in.missed_half_wave_count[0]);
+
+    // One pulse is missing: The input stays high for 30 ms instead of 10 ms. The gap
+    // is two half-waves longer than expected, each of them is counted.
+    sim.signal[0].ac = false;
+    sim_run(25000);
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(500000);
+
+    TEST_ASSERT(is_present(0));
+    TEST_ASSERT_EQUAL(2, ac_in.missed_half_wave_count[0]);
+}
+
+int main(int argc, char **argv) {
+    const Test tests[] = {
+        TEST(test_presence_after_first_edge),
+        TEST(test_loss_fixed_timeout),
+        TEST(test_loss_adaptive_timeout),
+        TEST(test_no_loss_with_steady_ac),
+        TEST(test_loss_across_timestamp_wraparound),
+        TEST(test_edge_newer_than_tick_time),
+        TEST(test_filter_min_edges),
+        TEST(test_filter_min_edges_within_timeout),
+        TEST(test_filter_rejects_glitches),
+        TEST(test_filter_keeps_edge_timing),
+        TEST(test_filter_long_pulse_width),
+        TEST(test_frequency_and_duty_cycle),
+        TEST(test_missed_half_wave),
+    };
+
+    return test_run(tests, sizeof(tests)/sizeof(tests[0]), argc, argv);
+}
@@ -0,0 +1,355 @@
+/* industrial-dual-ac-in-bricklet
+ * Copyright (C) 2023 Olaf Lüke <olaf@tinkerfoe.com>
+ *
+ * test_communication.c: Tests for the callback period, has-to-change and thresholds
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "test.h"
+#include "sim.h"
+
+#include "bricklib2/utility/util_definitions.h"
+#include "communication.h"
+
+#define PERIOD_50HZ 20000
+
+bool test_failed;
+
+// Like on the hardware the value starts with the input level. Without AC the
+// input is high, so both channels are only reported as absent after the timeout.
+static void start(void) {
+    sim_init(0);
+    sim_run(200000);
+}
+
+static void set_value_callback(const uint8_t channel, const uint32_t period, const bool value_has_to_change) {
+    SetValueCallbackConfiguration request = {.channel = channel, .period = period, .value_has_to_change = value_has_to_change};
+    sim_request(&request, sizeof(request), FID_SET_VALUE_CALLBACK_CONFIGURATION, NULL);
+}
+
+static BootloaderHandleMessageResponse set_duty_cycle_callback(const uint8_t channel, const uint32_t period, const bool value_has_to_change,
+                                                               const char option, const uint16_t min, const uint16_t max) {
+    SetDutyCycleCallbackConfiguration request = {
+        .channel = channel, .period = period, .value_has_to_change = value_has_to_change,
+        .option = option, .min = min, .max = max
+    };
+    return sim_request(&request, sizeof(request), FID_SET_DUTY_CYCLE_CALLBACK_CONFIGURATION, NULL);
+}
+
+static const Value_Callback *get_value_callback(const uint32_t index) {
+    const SimMessage *message = sim_get_message(FID_CALLBACK_VALUE, index);
+    return message == NULL ? NULL : (const Value_Callback*)message->data;
+}
+
+static uint16_t outage_log_length(void) {
+    GetOutageLogLength request;
+    GetOutageLogLength_Response response;
+    sim_request(&request, sizeof(request), FID_GET_OUTAGE_LOG_LENGTH, &response);
+    return response.length;
+}
+
+static void test_value_callback_period(void) {
+    const uint32_t periods[] = {1, 10, 100, 1000};
+
+    for(size_t i = 0; i < sizeof(periods)/sizeof(periods[0]); i++) {
+        start();
+        set_value_callback(0, periods[i], false);
+        sim_run(periods[i]*100000);
+
+        // The first callback is sent right away
+        TEST_ASSERT_BETWEEN(99, sim_get_message_count(FID_CALLBACK_VALUE), 101);
+
+        for(uint32_t j = 1; j < MIN(sim.message_count, SIM_MESSAGE_NUM); j++) {
+            const uint64_t interval = sim.message[j].time_us - sim.message[j - 1].time_us;
+            TEST_ASSERT_BETWEEN(periods[i]*1000 - 1000, interval, periods[i]*1000 + 1000);
+        }
+
+        const Value_Callback *cb = get_value_callback(0);
+        TEST_ASSERT(cb != NULL);
+        TEST_ASSERT_EQUAL(0, cb->channel);
+        TEST_ASSERT_EQUAL(false, cb->changed);
+        TEST_ASSERT_EQUAL(false, cb->value);
+    }
+}
+
+static void test_value_callback_disabled(void) {
+    start();
+    set_value_callback(0, 0, false);
+    set_value_callback(1, 0, true);
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_set_ac(1, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(1000000);
+
+    TEST_ASSERT_EQUAL(0, sim.message_count);
+}
+
+static void test_value_callback_has_to_change(void) {
+    start();
+    set_value_callback(1, 10, true);
+    sim_run(1000000);
+    TEST_ASSERT_EQUAL(0, sim_get_message_count(FID_CALLBACK_VALUE));
+
+    sim_set_ac(1, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(1000000);
+    TEST_ASSERT_EQUAL(1, sim_get_message_count(FID_CALLBACK_VALUE));
+
+    const Value_Callback *cb = get_value_callback(0);
+    TEST_ASSERT_EQUAL(1, cb->channel);
+    TEST_ASSERT_EQUAL(true, cb->changed);
+    TEST_ASSERT_EQUAL(true, cb->value);
+
+    sim.signal[1].ac = false;
+    sim_run(1000000);
+    TEST_ASSERT_EQUAL(2, sim_get_message_count(FID_CALLBACK_VALUE));
+
+    cb = get_value_callback(1);
+    TEST_ASSERT_EQUAL(1, cb->channel);
+    TEST_ASSERT_EQUAL(true, cb->changed);
+    TEST_ASSERT_EQUAL(false, cb->value);
+}
+
+static void test_value_callback_buffered(void) {
+    start();
+    set_value_callback(0, 10, true);
+
+    // A callback that can't be sent is kept until SPITFP is ready again
+    sim.send_possible = false;
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(500000);
+    TEST_ASSERT_EQUAL(0, sim.message_count);
+
+    sim.send_possible = true;
+    sim_run(100000);
+    TEST_ASSERT_EQUAL(1, sim_get_message_count(FID_CALLBACK_VALUE));
+    TEST_ASSERT_EQUAL(true, get_value_callback(0)->value);
+}
+
+static void test_immediate_value_callback(void) {
+    start();
+    set_value_callback(0, 1000, true);
+
+    SetImmediateValueCallbackConfiguration request = {.channel = 0, .enabled = true};
+    sim_request(&request, sizeof(request), FID_SET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION, NULL);
+
+    // Sent in the main loop iteration after the first edge, not with the 1 s period
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(100);
+    TEST_ASSERT_EQUAL(1, sim_get_message_count(FID_CALLBACK_VALUE));
+    TEST_ASSERT_EQUAL(true, get_value_callback(0)->value);
+    TEST_ASSERT(sim_get_message(FID_CALLBACK_VALUE, 0)->time_us - sim.last_edge[0] < 100);
+
+    // The periodic callback does not report the same change again
+    sim_run(2000000);
+    TEST_ASSERT_EQUAL(1, sim_get_message_count(FID_CALLBACK_VALUE));
+
+    sim.signal[0].ac = false;
+    sim_run(200000);
+    TEST_ASSERT_EQUAL(2, sim_get_message_count(FID_CALLBACK_VALUE));
+    TEST_ASSERT_EQUAL(false, get_value_callback(1)->value);
+    TEST_ASSERT_BETWEEN(99000, sim_get_message(FID_CALLBACK_VALUE, 1)->time_us - sim.last_edge[0], 101000);
+}
+
+static void test_immediate_value_callback_reports_every_transition(void) {
+    start();
+
+    SetImmediateValueCallbackConfiguration request = {.channel = 0, .enabled = true};
+    sim_request(&request, sizeof(request), FID_SET_IMMEDIATE_VALUE_CALLBACK_CONFIGURATION, NULL);
+
+    // AC appears, is lost and appears again while nothing can be sent.
+    // The first change waits in the send buffer, the other two are pending.
+    sim.send_possible = false;
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(100000);
+    sim.signal[0].ac = false;
+    sim_run(200000);
+    TEST_ASSERT(!(ac_in.value & 1));
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(100000);
+    TEST_ASSERT(ac_in.value & 1);
+
+    sim.send_possible = true;
+    sim_run(10000);
+    TEST_ASSERT_EQUAL(3, sim_get_message_count(FID_CALLBACK_VALUE));
+    TEST_ASSERT_EQUAL(true, get_value_callback(0)->value);
+    TEST_ASSERT_EQUAL(false, get_value_callback(1)->value);
+    TEST_ASSERT_EQUAL(true, get_value_callback(2)->value);
+}
+
+static void test_configuration_persistence(void) {
+    start();
+    set_value_callback(1, 250, true);
+
+    SetDetectionConfiguration detection = {.channel = 0, .mode = INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE, .timeout = 500, .missed_edges = 4};
+    sim_request(&detection, sizeof(detection), FID_SET_DETECTION_CONFIGURATION, NULL);
+
+    // Without save_configuration a reset restores the defaults
+    sim_reset();
+    TEST_ASSERT_EQUAL(0, ac_in.cb_value_period[1]);
+    TEST_ASSERT_EQUAL(INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_FIXED, ac_in.detection_mode[0]);
+
+    set_value_callback(1, 250, true);
+    sim_request(&detection, sizeof(detection), FID_SET_DETECTION_CONFIGURATION, NULL);
+    SetFilterConfiguration filter = {.channel = 1, .min_pulse_width = 1500, .min_edges = 3};
+    sim_request(&filter, sizeof(filter), FID_SET_FILTER_CONFIGURATION, NULL);
+    SaveConfiguration save;
+    sim_request(&save, sizeof(save), FID_SAVE_CONFIGURATION, NULL);
+
+    // Page 0 belongs to the bootloader
+    for(uint16_t i = 0; i < EEPROM_PAGE_SIZE; i++) {
+        TEST_ASSERT_EQUAL(0, sim.eeprom[i]);
+    }
+
+    sim_reset();
+    TEST_ASSERT_EQUAL(250, ac_in.cb_value_period[1]);
+    TEST_ASSERT_EQUAL(true, ac_in.cb_value_has_to_change[1]);
+    TEST_ASSERT_EQUAL(INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_ADAPTIVE, ac_in.detection_mode[0]);
+    TEST_ASSERT_EQUAL(500, ac_in.detection_timeout[0]);
+    TEST_ASSERT_EQUAL(4, ac_in.detection_missed_edges[0]);
+    TEST_ASSERT_EQUAL(1500, ac_in.filter_pulse_width[1]);
+    TEST_ASSERT_EQUAL(3, ac_in.filter_min_edges[1]);
+
+    ClearConfiguration clear;
+    sim_request(&clear, sizeof(clear), FID_CLEAR_CONFIGURATION, NULL);
+    sim_reset();
+    TEST_ASSERT_EQUAL(0, ac_in.cb_value_period[1]);
+    TEST_ASSERT_EQUAL(INDUSTRIAL_DUAL_AC_IN_DETECTION_MODE_FIXED, ac_in.detection_mode[0]);
+}
+
+static void test_outage_log(void) {
+    start();
+    sim_set_ac(0, 20000, 10000);
+    sim_run(500000);
+
+    // A short outage is logged and written right away, so it survives a reset
+    sim.signal[0].ac = false;
+    sim_run(300000);
+    sim_set_ac(0, 20000, 10000);
+    sim_run(1000);
+    sim_reset();
+    TEST_ASSERT_EQUAL(1, outage_log_length());
+
+    GetOutageLogEntry request = {.index = 0};
+    GetOutageLogEntry_Response response;
+    TEST_ASSERT_EQUAL(HANDLE_MESSAGE_RESPONSE_NEW_MESSAGE, sim_request(&request, sizeof(request), FID_GET_OUTAGE_LOG_ENTRY, &response));
+    TEST_ASSERT_EQUAL(0, response.channel);
+    TEST_ASSERT_BETWEEN(190, response.duration, 220); // Counted from the loss detection
+
+    // While the input flaps the writes back off, but no entry is lost
+    sim_set_ac(0, 20000, 10000);
+    sim_run(500000);
+    const uint32_t write_count = sim.eeprom_write_count;
+    for(uint8_t i = 0; i < 20; i++) {
+        sim.signal[0].ac = false;
+        sim_run(300000);
+        sim_set_ac(0, 20000, 10000);
+        sim_run(200000);
+    }
+    TEST_ASSERT(sim.eeprom_write_count - write_count <= 6);
+
+    sim_run(20000000);
+    TEST_ASSERT_EQUAL(21, outage_log_length());
+}
+
+static void test_duty_cycle_threshold(void) {
+    const struct {
+        char option;
+        uint16_t min;
+        uint16_t max;
+        bool triggered; // for a duty cycle of 50.00%
+    } cases[] = {
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OFF,     0,    0,    true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE,  4000, 6000, true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE,  6000, 8000, false},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE, 4000, 6000, false},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE, 6000, 8000, true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER, 6000, 0,    true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER, 4000, 0,    false},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER, 4000, 0,    true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER, 6000, 0,    false},
+
+        // Bounds are inclusive for inside and outside, exclusive for smaller and greater
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_INSIDE,  5000, 5000, true},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_OUTSIDE, 5000, 5000, false},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_SMALLER, 5000, 0,    false},
+        {INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER, 5000, 0,    false},
+    };
+
+    for(size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+        start();
+        sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+        sim_run(1000000);
+        TEST_ASSERT_EQUAL(5000, ac_in.duty_cycle[0]);
+
+        TEST_ASSERT_EQUAL(HANDLE_MESSAGE_RESPONSE_EMPTY, set_duty_cycle_callback(0, 100, false, cases[i].option, cases[i].min, cases[i].max));
+        sim_run(1000000);
+
+        if(cases[i].triggered) {
+            TEST_ASSERT_BETWEEN(9, sim_get_message_count(FID_CALLBACK_DUTY_CYCLE), 11);
+
+            const DutyCycle_Callback *cb = (const DutyCycle_Callback*)sim_get_message(FID_CALLBACK_DUTY_CYCLE, 0)->data;
+            TEST_ASSERT_EQUAL(0, cb->channel);
+            TEST_ASSERT_EQUAL(5000, cb->duty_cycle);
+            TEST_ASSERT_EQUAL(10000, cb->on_time);
+            TEST_ASSERT_EQUAL(10000, cb->off_time);
+        } else {
+            TEST_ASSERT_EQUAL(0, sim_get_message_count(FID_CALLBACK_DUTY_CYCLE));
+        }
+    }
+}
+
+static void test_duty_cycle_threshold_has_to_change(void) {
+    start();
+    sim_set_ac(0, PERIOD_50HZ, PERIOD_50HZ/2);
+    sim_run(1000000);
+
+    // Only changes that end up above the threshold are reported
+    set_duty_cycle_callback(0, 10, true, INDUSTRIAL_DUAL_AC_IN_THRESHOLD_OPTION_GREATER, 6000, 0);
+    sim_run(1000000);
+    TEST_ASSERT_EQUAL(0, sim_get_message_count(FID_CALLBACK_DUTY_CYCLE));
+
+    sim_set_ac(0, PERIOD_50HZ, 14000);
+    sim_run(2000000);
+    TEST_ASSERT_EQUAL(1, sim_get_message_count(FID_CALLBACK_DUTY_CYCLE));
+
+    const DutyCycle_Callback *cb = (const DutyCycle_Callback*)sim_get_message(FID_CALLBACK_DUTY_CYCLE, 0)->data;
+    TEST_ASSERT(cb->duty_cycle > 6000);
+}
+
+static void test_threshold_option_invalid(void) {
+    start();
+    TEST_ASSERT_EQUAL(HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER, set_duty_cycle_callback(0, 100, false, 'z', 0, 0));
+    TEST_ASSERT_EQUAL(HANDLE_MESSAGE_RESPONSE_INVALID_PARAMETER, set_duty_cycle_callback(2, 100, false, 'x', 0, 0));
+    TEST_ASSERT_EQUAL(0, ac_in.cb_duty_cycle_period[0]);
+}
+
+int main(int argc, char **argv) {
+    const Test tests[] = {
+        TEST(test_value_callback_period),
+        TEST(test_value_callback_disabled),
+        TEST(test_value_callback_has_to_change),
+        TEST(test_value_callback_buffered),
+        TEST(test_immediate_value_callback),
+        TEST(test_immediate_value_callback_reports_every_transition),
+        TEST(test_configuration_persistence),
+        TEST(test_outage_log),
+        TEST(test_duty_cycle_threshold),
+        TEST(test_duty_cycle_threshold_has_to_change),
+        TEST(test_threshold_option_invalid),
+    };
+
+    return test_run(tests, sizeof(tests)/sizeof(tests[0]), argc, argv);
+}